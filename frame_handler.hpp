@@ -37,10 +37,15 @@ class frame_handler {
   // with all chunks of a frame. Wired up via set_release_slab_callback so frame_handler
   // doesn't need to know about rtp::Receiver directly.
   using ReleaseSlabCb = void (*)(void *user, size_t slab_idx);
+  // Bulk form: releases `slab_idx` and every slab delivered before it in one call
+  // (rtp::Receiver::release_through). Valid here because each packet's slab is either
+  // released at once or held until the frame ends, so at release_held_slabs() nothing
+  // older than the newest held slab is still in use.
+  using ReleaseThroughCb = void (*)(void *user, size_t slab_idx);
 
   // Fired once per completed frame at EOC (see set_frame_ready_callback). Declared here,
   // ahead of the data members that reference it.
-  using FrameReadyCb = void (*)(void *user, const codestream &cs, bool intact);
+  using FrameReadyCb = void (*)(void *user, const codestream &cs, bool intact, uint32_t incomplete_levels);
 
   // ---- Incremental (sub-frame) delivery — see set_chunk_callback ----
   // Fired for EVERY byte range appended to the current frame's codestream, in codestream
@@ -87,9 +92,12 @@ class frame_handler {
   //                       frames died in PARSE failures (gap/loss frames are
   //                       neutral), so the latched structure itself is suspect;
   //                       re-latched from the next clean main header
+  //   kRelatchRestart   — the transport saw the sender restart (restart_stream());
+  //                       re-latched from the next clean main header
   using StreamRelatchCb                  = void (*)(void *user, int reason);
   static constexpr int kRelatchGeometry  = 1;
   static constexpr int kRelatchParseFail = 2;
+  static constexpr int kRelatchRestart   = 3;
 
   // ---- Transport-assisted mid-frame resync (C2 Stage C; consumer = a decoder
   // that can resume at an RFC 9828 resync point, e.g. the H2L1 PL).
@@ -124,6 +132,10 @@ class frame_handler {
 
   ReleaseSlabCb release_slab_cb_;
   void *release_slab_arg_;
+  ReleaseThroughCb release_through_cb_ = nullptr;
+  void *release_through_arg_           = nullptr;
+  // pull_data aborts the frame once this many slabs are held (missed EOC).
+  size_t held_slab_cap_;
 
   FrameReadyCb frame_ready_cb_ = nullptr;
   void *frame_ready_arg_       = nullptr;
@@ -143,7 +155,10 @@ class frame_handler {
   uint32_t parse_fail_streak_    = 0;      // consecutive frames dead by PARSE failure
   bool frame_parse_failed_       = false;  // current frame died by a parse failure (not a gap)
   size_t relatches_              = 0;
+  int restart_relatch_           = 0;      // kRelatchRestart until the next re-latch completes
   bool resync_armed_             = false;  // gap accepted by the consumer; offering points
+  uint8_t shed_levels_           = 0;      // set_resolution_shed: applied at each main packet
+  size_t shed_frames_            = 0;      // frames completed with levels shed
   // True from the first accepted gap until the frame ends: the SOFTWARE precinct
   // walk is parked (it would garbage-parse at the compaction seam and abort the
   // frame — the resync consumer's own decoder handles the seam), while chunk
@@ -180,8 +195,25 @@ class frame_handler {
     frame_parse_failed_ = false;
   }
 
+  // Closes a frame whose EOC never arrived: kAbortMissedEOC, and counted truncated if it
+  // got past its main header or had already failed.
+  void close_open_frame() {
+    fire_abort(kAbortMissedEOC);
+    release_held_slabs();
+    tile_hndr.restart(0);
+    if (is_passed_header || is_parsing_failure) {
+      trunc_frames++;
+      total_frames++;
+      end_frame_streak(false);
+    }
+    is_parsing_failure = 0;
+    is_passed_header   = 0;
+  }
+
   void release_held_slabs() {
-    if (release_slab_cb_) {
+    if (release_through_cb_) {
+      if (!held_slabs_.empty()) release_through_cb_(release_through_arg_, held_slabs_.back());
+    } else if (release_slab_cb_) {
       for (size_t idx : held_slabs_) release_slab_cb_(release_slab_arg_, idx);
     }
     held_slabs_.clear();
@@ -201,7 +233,8 @@ class frame_handler {
         cumlative_time(0.0),
         cs(),
         release_slab_cb_(nullptr),
-        release_slab_arg_(nullptr) {
+        release_slab_arg_(nullptr),
+        held_slab_cap_(3072) {
     start_time = std::chrono::high_resolution_clock::now();
     held_slabs_.reserve(2048);
   }
@@ -225,12 +258,29 @@ class frame_handler {
     release_slab_arg_ = arg;
   }
 
+  // Optional: when set, held slabs go back with one call per frame instead of one
+  // release_slab_cb_ per packet. release_slab_cb_ is still needed for the packets
+  // released at once (body packets while not tracking a frame).
+  void set_release_through_callback(ReleaseThroughCb cb, void *arg) {
+    release_through_cb_  = cb;
+    release_through_arg_ = arg;
+  }
+
+  // Runaway cap on held slabs (see pull_data). Size it from the receiver's pool:
+  // rtp::Receiver::held_slab_cap(). The default matches its default 16384-slab pool.
+  void set_held_slab_cap(size_t n) { held_slab_cap_ = n; }
+  size_t get_held_slab_cap() const { return held_slab_cap_; }
+
   // Frame-ready callback: fired once per completed frame at EOC, BEFORE the held slabs
   // are released — so `cs`'s zero-copy chain is still valid for the duration of the call.
   // `intact` is true iff the main header parsed and no precinct parse failure occurred
-  // (false = damaged: lost packets or a parse failure). A frame-granular consumer (e.g.
-  // an FPGA whole-frame decoder) can pull the contiguous codestream via cs.for_each_chunk()
-  // inside the callback. Independent of (and composable with) the per-precinct callback.
+  // (false = damaged: lost packets or a parse failure). `incomplete_levels` has bit r set
+  // when resolution level r lost precincts to the software walk — shed under load (see
+  // set_resolution_shed) or skipped by parse-failure recovery — so the precinct callback
+  // did not fire for all of that level; the codestream bytes are complete regardless.
+  // A frame-granular consumer (e.g. an FPGA whole-frame decoder) can pull the contiguous
+  // codestream via cs.for_each_chunk() inside the callback. Independent of (and
+  // composable with) the per-precinct callback.
   void set_frame_ready_callback(FrameReadyCb cb, void *arg) {
     frame_ready_cb_  = cb;
     frame_ready_arg_ = arg;
@@ -270,6 +320,27 @@ class frame_handler {
   void set_relatch_parse_fail_k(uint32_t k) { relatch_k_ = k; }
   size_t get_relatches() const { return relatches_; }
 
+  // Resolution-priority load shedding: from the next frame's main packet on, the parser
+  // skips precincts in each component's `levels` highest resolution levels (level 0 is
+  // always kept) instead of parsing them — the precinct callback sees only the lower
+  // resolutions and frame_ready reports the rest in incomplete_levels. Byte delivery
+  // (chunk and frame-ready consumers) is unchanged. Meant to be driven per frame by the
+  // caller's view of worker lag (main.cpp: the receiver's job backlog); 0 stops shedding.
+  void set_resolution_shed(uint8_t levels) { shed_levels_ = levels; }
+  size_t get_shed_frames() const { return shed_frames_; }
+
+  // The sender restarted (rtp::Receiver: Frame::restart — a new SSRC or a sequence jump
+  // far past the jitter window). Call before passing that packet to pull_data. Any open
+  // frame is closed as a lost EOC, and the stream is re-latched from the next complete
+  // main header (kRelatchRestart) rather than trusting the old latch until a parse
+  // failure or signature mismatch shows up.
+  void restart_stream() {
+    if (is_passed_header || is_parsing_failure || !held_slabs_.empty()) close_open_frame();
+    if (!tile_hndr.is_ready()) return;  // nothing latched yet: the first latch is not a re-latch
+    tile_hndr.invalidate();
+    restart_relatch_ = kRelatchRestart;
+  }
+
 #ifdef PARSER_OVERSHOOT_INSTR
   tile_handler::OvershootStats get_overshoot_stats() const { return tile_hndr.get_overshoot_stats(); }
   void reset_overshoot_stats() { tile_hndr.reset_overshoot_stats(); }
@@ -298,11 +369,19 @@ class frame_handler {
   // detection immediate and deterministic for the incremental consumer: the frame is
   // aborted at the gap instead of waiting for a downstream parse failure to notice.
   // Callers that don't track seq (the default) keep today's parse-level detection.
-  void pull_data(uint8_t *__restrict__ payload, size_t size, int marker, size_t slab_idx,
-                 bool gap = false) {
+  // rtp::Receiver computes it per packet (Frame::gap).
+  // `new_timestamp` (optional): this packet's RTP timestamp differs from the previous
+  // packet's (rtp::Receiver: Frame::new_timestamp). A frame still open at that point lost
+  // its marker packet; it is closed right here, as truncated, instead of holding its
+  // slabs until the next main packet shows up (which may be lost too).
+  // Always inlined: its caller is the receiver's per-packet job loop (main.cpp's RtpSink),
+  // and at this size the compiler would otherwise keep the call.
+  [[gnu::always_inline]] void pull_data(uint8_t *__restrict__ payload, size_t size, int marker, size_t slab_idx,
+                                        bool gap = false, bool new_timestamp = false) {
     // A gap kills any in-flight frame: bytes are missing, so neither the parser nor a
     // byte-stream consumer can use what follows. Mark it failed — the body-skip path
-    // below then drops packets until the next main packet resyncs us. (A gap with
+    // below then drops packets until the next main packet resyncs us — and hand its
+    // slabs back now rather than at its EOC: nothing will read them again. (A gap with
     // nothing in flight lost only packets of frames we never started: nothing to do.)
     // C2 Stage C exception: a resync-capable consumer may ACCEPT the gap instead —
     // the chain then keeps delivering (compacted) and ORDB points are offered until
@@ -314,16 +393,22 @@ class frame_handler {
       } else {
         fire_abort(kAbortGap);
         is_parsing_failure = 1;
+        release_held_slabs();
       }
     }
 
+    // A new RTP timestamp with a frame still open: its EOC packet never came. Close it as
+    // the next main packet would (kAbortMissedEOC, counted truncated), so this packet
+    // starts clean — or, being a body packet, is skipped until the next main packet.
+    if (new_timestamp && (is_passed_header || is_parsing_failure || !held_slabs_.empty())) close_open_frame();
+
     // Safety: if EOC has been missed for many packets, held_slabs_ would otherwise grow
     // unbounded and exhaust the receiver's slot ring (causing busy/net drop cascades).
-    // 3072 leaves ~1024 slots of headroom in a 4096-slot ring — enough for a couple of
-    // typical frames in flight while preventing runaway. After firing, we wait for the
+    // The cap (set_held_slab_cap) is a couple of frames in flight, well short of the
+    // receiver's pool, while preventing runaway. After firing, we wait for the
     // next MH packet before resuming parsing (otherwise cs.reset(start_SOD) would
     // position us inside a body chunk).
-    if (held_slabs_.size() >= 3072) {
+    if (held_slabs_.size() >= held_slab_cap_) {
       fire_abort(kAbortSlabCap);
       release_held_slabs();
       tile_hndr.restart(0);
@@ -367,23 +452,16 @@ class frame_handler {
     if (MH >= 1) {  // Main packet — start of a new frame's main header bytes.
       log_init(total_frames);
       // Defensive: if we missed previous frame's EOC, the chain still holds stale
-      // chunks. Release them so this MH starts a fresh chain.
-      if (!held_slabs_.empty()) {
-        fire_abort(kAbortMissedEOC);  // the open frame will never complete
-        release_held_slabs();
-        tile_hndr.restart(0);
-        // Count the abandoned frame once. is_parsing_failure covers a frame rejected at
-        // create()/parse whose EOC was lost on the wire (is_passed_header never set);
-        // mirrors the EOC early-skip block's condition so counts stay consistent.
-        if (is_passed_header || is_parsing_failure) {
-          trunc_frames++;
-          total_frames++;
-          end_frame_streak(false);
-        }
-        is_passed_header = 0;
-      }
+      // chunks. Release them so this MH starts a fresh chain. (A gap-aborted frame has
+      // already released its chunks but is still uncounted.)
+      // The abandoned frame is counted once. is_parsing_failure covers a frame rejected
+      // at create()/parse whose EOC was lost on the wire (is_passed_header never set);
+      // close_open_frame mirrors the EOC early-skip block's condition so counts stay
+      // consistent.
+      if (!held_slabs_.empty() || is_parsing_failure) close_open_frame();
       is_parsing_failure  = 0;
       frame_parse_failed_ = false;
+      tile_hndr.set_shed_levels(shed_levels_);
       deliver_chunk(chain_total_bytes_, j2k_payload, size);
       cs.append_chunk(j2k_payload, size);
       held_slabs_.push_back(slab_idx);
@@ -396,7 +474,7 @@ class frame_handler {
       // until relaunch (field wedge, 2026-07-14).
       uint64_t sig = 0;
       uint32_t sod = 0;
-      int relatch  = 0;
+      int relatch  = restart_relatch_;
       if (MH >= 2) {
         sig = geometry_signature(j2k_payload, size, &sod);
         if (sig == 0 && tile_hndr.is_ready()) {
@@ -435,6 +513,7 @@ class frame_handler {
           is_passed_header   = 1;
           geom_sig_          = sig;
           parse_fail_streak_ = 0;
+          restart_relatch_   = 0;
           if (relatch) {  // fired AFTER the new structure is live (worker thread)
             relatches_++;
             if (relatch_cb_) relatch_cb_(relatch_arg_, relatch);
@@ -498,7 +577,8 @@ class frame_handler {
       save_j2c(total_frames, cs);
       // Hand the completed frame to a frame-granular consumer while cs's chain is still
       // valid (the held slabs are released just below). intact=false => damaged frame.
-      if (frame_ready_cb_) frame_ready_cb_(frame_ready_arg_, cs, frame_intact);
+      if (frame_ready_cb_) frame_ready_cb_(frame_ready_arg_, cs, frame_intact, tile_hndr.incomplete_levels());
+      shed_frames_ += frame_intact && tile_hndr.get_shed_levels() && tile_hndr.incomplete_levels();
       trunc_frames += is_parsing_failure;
       total_frames++;
 
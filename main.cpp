@@ -1,7 +1,11 @@
 #include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <frame_handler.hpp>
 #include "rtp_receiver.hpp"
@@ -24,6 +28,23 @@ struct params_t {
   rtp::Receiver *receiver;
   size_t total_frames;
   uint32_t last_timetamp;
+  size_t last_recv_calls;
+  size_t last_recv_datagrams;
+  size_t last_worker_wakeups;
+  size_t last_worker_spins;
+  size_t last_inline_frames;
+  size_t last_handoff_frames;
+  bool multi_socket;
+  bool dual_path;
+  bool fec;
+  bool nack;
+  bool srtp;
+  bool relay;
+  bool parse;
+  bool run_to_completion;
+  bool adaptive_jitter;
+  uint8_t shed_levels;
+  size_t shed_backlog;
 };
 
 #ifdef __linux__
@@ -152,12 +173,72 @@ void check_nic_irq_affinity(const char *bind_addr, int recv_cpu, int worker_cpu)
 static void check_nic_irq_affinity(const char *, int, int) {}
 #endif
 
-static void rtp_receive_hook(void *arg, const rtp::Frame &frame);
+[[gnu::cold, gnu::noinline]] static void print_stats(params_t *p, uint32_t timestamp);
+
+// Worker-thread packet handler. Passed to Receiver::start by reference, so the receiver's
+// job loop is instantiated for it and pull_data inlines there (no std::function, no void*
+// round trip per packet); the stats line is the cold path.
+struct RtpSink {
+  params_t *p;
+  [[gnu::always_inline]] void operator()(const rtp::Packet &pkt) const {
+    if (pkt.restart()) {
+      p->frame_handler->restart_stream();
+      p->last_timetamp = 0;  // the new sender's timestamps have an unrelated base
+    }
+    // Resolution shedding, decided per frame from the worker's backlog at its first packet.
+    if (p->shed_levels && pkt.new_timestamp())
+      p->frame_handler->set_resolution_shed(p->receiver->queued_jobs() > p->shed_backlog ? p->shed_levels : 0);
+    p->frame_handler->pull_data(pkt.payload(), pkt.payload_len() - 8, pkt.marker(), pkt.slab_idx(), pkt.gap(),
+                                pkt.new_timestamp());
+    const uint32_t timestamp = pkt.timestamp();
+    if (p->last_timetamp == 0) {
+      p->last_timetamp = timestamp;
+    }
+    if (timestamp >= p->last_timetamp + 45000) print_stats(p, timestamp);
+  }
+};
+
+// Worker-thread handler with parsing off (parse=0): the relay has already sent the packet
+// by the time it gets here, so its slab goes straight back to the pool.
+struct ReleaseSink {
+  params_t *p;
+  void operator()(const rtp::Packet &pkt) const {
+    if (pkt.restart()) p->last_timetamp = 0;
+    const uint32_t timestamp = pkt.timestamp();  // read before the slab can be reused
+    p->receiver->release_slab(pkt.slab_idx());
+    if (p->last_timetamp == 0) {
+      p->last_timetamp = timestamp;
+    }
+    if (timestamp >= p->last_timetamp + 45000) print_stats(p, timestamp);
+  }
+};
+
+// SDES inline key material (RFC 4568): base64 of master key || master salt. Empty on a
+// character outside the alphabet.
+static std::vector<uint8_t> decode_base64(const std::string &in) {
+  std::vector<uint8_t> out;
+  uint32_t acc = 0;
+  int bits     = 0;
+  for (const char c : in) {
+    if (c == '=') break;
+    const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const char *at       = std::strchr(alphabet, c);
+    if (c == '\0' || at == nullptr) return {};
+    acc = (acc << 6) | static_cast<uint32_t>(at - alphabet);
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      out.push_back(static_cast<uint8_t>(acc >> bits));
+    }
+  }
+  return out;
+}
 
 void print_help(char *cmd) {
   std::cout
       << "Usage: " << cmd
       << " address port [duration(s)] [wait(ms)] [holdback] [recv_cpu] [worker_cpu] [recv_buf_mb]"
+         " [recv_batch] [key=value ...]"
       << std::endl;
   std::cout << "  duration:    seconds to listen (default: forever)" << std::endl;
   std::cout << "  wait(ms):    deprecated, ignored (kept for arg-position compatibility)" << std::endl;
@@ -166,10 +247,94 @@ void print_help(char *cmd) {
   std::cout << "  recv_cpu:    CPU to pin recv thread (default 2; -1 = no pinning)" << std::endl;
   std::cout << "  worker_cpu:  CPU to pin worker thread (default 3; -1 = no pinning)" << std::endl;
   std::cout << "  recv_buf_mb: SO_RCVBUF in megabytes (default 16)" << std::endl;
+  std::cout << "  recv_batch:  datagrams per recvmmsg() call (default 1 = plain recv())" << std::endl;
+  std::cout << "Options (after the positional args):" << std::endl;
+  std::cout << "  ingest=MODE                      ingest backend: socket (default), packet_ring, uring,"
+            << std::endl;
+  std::cout << "                                   tcp (RFC 4571 RTP over TCP; listens on address)" << std::endl;
+  std::cout << "  iface=NAME                       packet_ring interface (default: owner of address)"
+            << std::endl;
+  std::cout << "  gro=0|1                          UDP_GRO coalesced receive, socket ingest (default 0)"
+            << std::endl;
+  std::cout << "  sockets=N                        SO_REUSEPORT receive sockets, socket ingest (default 1)"
+            << std::endl;
+  std::cout << "  sock_cpus=A,B,...                CPUs for the per-socket threads (default: unpinned)"
+            << std::endl;
+  std::cout << "  redundant=ADDR:PORT              SMPTE 2022-7 second path, socket ingest (default: none)"
+            << std::endl;
+  std::cout << "  fec=PORT[,ROW_PORT]              SMPTE 2022-1 FEC parity port(s), socket ingest (default: none)"
+            << std::endl;
+  std::cout << "  nack=ADDR:PORT                   send RTCP NACKs there, receive RTX retransmissions (default: none)"
+            << std::endl;
+  std::cout << "  rtx_pt=PT                        payload type of the RTX stream (default 97)" << std::endl;
+  std::cout << "  nack_frames=N                    frame periods (at fps) to wait for a retransmission (default 1)"
+            << std::endl;
+  std::cout << "  srtp=SUITE:KEY                   SRTP suite AES_CM_128_HMAC_SHA1_80 or AEAD_AES_128_GCM,"
+            << std::endl;
+  std::cout << "                                   KEY base64 master key||salt as in SDES (default: off)"
+            << std::endl;
+  std::cout << "  relay=ADDR:PORT[,ADDR:PORT...]   forward every packet there, sendmmsg + UDP GSO"
+            << std::endl;
+  std::cout << "                                   (default: none)" << std::endl;
+  std::cout << "  parse=0|1                        parse J2K (default 1); 0 with relay= only fans out"
+            << std::endl;
+  std::cout << "  worker_wait=MODE                 worker idle strategy: condvar (default), spin, spinpark,"
+            << std::endl;
+  std::cout << "                                   eventfd" << std::endl;
+  std::cout << "  worker_spin=N                    empty polls before spinpark/eventfd sleep (default 4096)"
+            << std::endl;
+  std::cout << "  busy_poll=USEC                   SO_BUSY_POLL on the socket(s) (default 0 = off)" << std::endl;
+  std::cout << "  busy_poll_prefer=0|1             SO_PREFER_BUSY_POLL with busy_poll (default 0)" << std::endl;
+  std::cout << "  busy_poll_budget=N               SO_BUSY_POLL_BUDGET with busy_poll (default: kernel's)"
+            << std::endl;
+  std::cout << "  slabs=N                          slab pool size (default: derived, or 16384)" << std::endl;
+  std::cout << "  bitrate_mbps=R                   stream bitrate to size the pool from (default: unset)"
+            << std::endl;
+  std::cout << "  fps=F                            frame rate, with bitrate_mbps (default 60)" << std::endl;
+  std::cout << "  hold_ms=MS                       history the pool holds, with bitrate_mbps (default 200)"
+            << std::endl;
+  std::cout << "  pkt_bytes=N                      typical datagram size, with bitrate_mbps (default 1400)"
+            << std::endl;
+  std::cout << "  max_datagram=N                   largest datagram accepted (default 9216)" << std::endl;
+  std::cout << "  slab_pages=small|thp|hugetlb     slab pool page size (default thp)" << std::endl;
+  std::cout << "  slab_lock=0|1                    mlock the slab pool (default 0)" << std::endl;
+  std::cout << "  slab_prefault=0|1                populate the slab pool in the background (default 1)"
+            << std::endl;
+  std::cout << "  rtc=0|1                          parse on the recv thread, run to completion (default 0)"
+            << std::endl;
+  std::cout << "  rtc_budget_us=N                  per-frame parse budget before handing off (default 5000)"
+            << std::endl;
+  std::cout << "  jitter_depth=N                   packets the ring waits for a missing one (default 64)"
+            << std::endl;
+  std::cout << "  jitter_max=N                     adapt the depth in [jitter_depth, N] to the reordering seen"
+            << std::endl;
+  std::cout << "                                   (default 0 = fixed depth)" << std::endl;
+  std::cout << "  admit=F                          shed whole frames once F x slabs are queued (default 0 = off)"
+            << std::endl;
+  std::cout << "  shed_levels=N                    resolution levels to skip while the worker lags (default 0)"
+            << std::endl;
+  std::cout << "  shed_backlog=N                   queued jobs that count as lagging, for shed_levels"
+            << std::endl;
+  std::cout << "                                   (default 2048)" << std::endl;
 }
 
 int main(int argc, char *argv[]) {
-  if (argc < 3) {
+  // Positional args come first; everything from the first key=value on is an option.
+  int nargs = 1;
+  while (nargs < argc && !std::strchr(argv[nargs], '=')) ++nargs;
+  auto option = [&](const char *key, const char *def) -> std::string {
+    const size_t klen = std::strlen(key);
+    for (int i = nargs; i < argc; ++i)
+      if (std::strncmp(argv[i], key, klen) == 0 && argv[i][klen] == '=') return argv[i] + klen + 1;
+    return def;
+  };
+  for (int i = nargs; i < argc; ++i) {
+    if (!std::strchr(argv[i], '=')) {
+      std::cerr << "Positional argument after options: " << argv[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (nargs < 3) {
     print_help(argv[0]);
     return EXIT_FAILURE;
   }
@@ -178,22 +343,24 @@ int main(int argc, char *argv[]) {
   const char *LOCAL_ADDRESS = argv[1];
   const uint16_t LOCAL_PORT = static_cast<uint16_t>(std::stoi(argv[2]));
   int64_t TIME_S            = INT64_MAX;
-  if (argc > 3) {
+  if (nargs > 3) {
     TIME_S = std::stoi(argv[3]);
   }
   const auto RECEIVE_TIME_S = std::chrono::seconds(TIME_S);
 
   [[maybe_unused]] size_t RECEIVER_WAIT_TIME_MS = 45;
-  if (argc > 4) {
+  if (nargs > 4) {
     RECEIVER_WAIT_TIME_MS = static_cast<size_t>(std::stoi(argv[4]));
   }
 
   int recv_cpu    = 2;
   int worker_cpu  = 3;
   int recv_buf_mb = 16;
-  if (argc > 6) recv_cpu = std::stoi(argv[6]);
-  if (argc > 7) worker_cpu = std::stoi(argv[7]);
-  if (argc > 8) recv_buf_mb = std::stoi(argv[8]);
+  int recv_batch  = 1;
+  if (nargs > 6) recv_cpu = std::stoi(argv[6]);
+  if (nargs > 7) worker_cpu = std::stoi(argv[7]);
+  if (nargs > 8) recv_buf_mb = std::stoi(argv[8]);
+  if (nargs > 9) recv_batch = std::stoi(argv[9]);
 
   // Receiver lives longer than frame_handler so frame_handler can call back into the
   // receiver during destruction or final EOC (C++ destroys locals in reverse order).
@@ -201,30 +368,197 @@ int main(int argc, char *argv[]) {
   receiver.set_recv_cpu(recv_cpu);
   receiver.set_worker_cpu(worker_cpu);
   receiver.set_recv_buf_size(recv_buf_mb * 1024 * 1024);
+  receiver.set_recv_batch(recv_batch > 0 ? static_cast<size_t>(recv_batch) : 1);
+  receiver.set_udp_gro(option("gro", "0") == "1");
+  const std::string ingest = option("ingest", "socket");
+  if (ingest == "packet_ring") {
+    receiver.set_ingest(rtp::Receiver::Ingest::kPacketRing);
+    receiver.set_packet_ring(option("iface", ""));
+  } else if (ingest == "uring") {
+    receiver.set_ingest(rtp::Receiver::Ingest::kIoUring);
+  } else if (ingest == "tcp") {
+    receiver.set_ingest(rtp::Receiver::Ingest::kTcp);
+  } else if (ingest != "socket") {
+    std::cerr << "Unknown ingest backend: " << ingest << std::endl;
+    return EXIT_FAILURE;
+  }
+  const int recv_sockets = std::stoi(option("sockets", "1"));
+  std::vector<int> sock_cpus;
+  {
+    std::stringstream ss(option("sock_cpus", ""));
+    for (std::string cpu; std::getline(ss, cpu, ',');)
+      if (!cpu.empty()) sock_cpus.push_back(std::stoi(cpu));
+  }
+  receiver.set_recv_sockets(recv_sockets > 0 ? static_cast<size_t>(recv_sockets) : 1, sock_cpus);
+  const std::string redundant = option("redundant", "");
+  if (!redundant.empty()) {
+    const size_t colon = redundant.rfind(':');
+    if (colon == std::string::npos) {
+      std::cerr << "redundant= needs ADDR:PORT: " << redundant << std::endl;
+      return EXIT_FAILURE;
+    }
+    receiver.set_redundant_path(redundant.substr(0, colon),
+                                static_cast<uint16_t>(std::stoi(redundant.substr(colon + 1))));
+  }
+  const std::string fec = option("fec", "");
+  if (!fec.empty()) {
+    const size_t comma = fec.find(',');
+    receiver.set_fec(static_cast<uint16_t>(std::stoi(fec.substr(0, comma))),
+                     comma == std::string::npos ? 0 : static_cast<uint16_t>(std::stoi(fec.substr(comma + 1))));
+  }
+  const std::string nack = option("nack", "");
+  if (!nack.empty()) {
+    const size_t colon = nack.rfind(':');
+    if (colon == std::string::npos) {
+      std::cerr << "nack= needs ADDR:PORT: " << nack << std::endl;
+      return EXIT_FAILURE;
+    }
+    // The deadline is counted in frames: a lost packet may cost that much latency, no more.
+    const double deadline_ms = std::stod(option("nack_frames", "1")) * 1000.0 / std::stod(option("fps", "60"));
+    receiver.set_retransmission(nack.substr(0, colon), static_cast<uint16_t>(std::stoi(nack.substr(colon + 1))),
+                                static_cast<uint8_t>(std::stoi(option("rtx_pt", "97"))), deadline_ms);
+  }
+  const std::string srtp = option("srtp", "");
+  if (!srtp.empty()) {
+    const size_t colon      = srtp.find(':');
+    const std::string suite = srtp.substr(0, colon);
+    const std::vector<uint8_t> key_salt =
+        colon == std::string::npos ? std::vector<uint8_t>{} : decode_base64(srtp.substr(colon + 1));
+    if (suite == "AES_CM_128_HMAC_SHA1_80") {
+      receiver.set_srtp(rtp::srtp::Suite::kAesCm128HmacSha1_80, key_salt.data(), key_salt.size());
+    } else if (suite == "AEAD_AES_128_GCM") {
+      receiver.set_srtp(rtp::srtp::Suite::kAeadAes128Gcm, key_salt.data(), key_salt.size());
+    } else {
+      std::cerr << "Unknown SRTP suite: " << suite << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (key_salt.empty()) {
+      std::cerr << "srtp= needs SUITE:BASE64KEY: " << srtp << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  const std::string relay = option("relay", "");
+  if (!relay.empty()) {
+    std::vector<std::pair<std::string, uint16_t>> dests;
+    std::stringstream ss(relay);
+    for (std::string dest; std::getline(ss, dest, ',');) {
+      const size_t colon = dest.rfind(':');
+      if (colon == std::string::npos) {
+        std::cerr << "relay= needs ADDR:PORT[,ADDR:PORT...]: " << relay << std::endl;
+        return EXIT_FAILURE;
+      }
+      dests.emplace_back(dest.substr(0, colon), static_cast<uint16_t>(std::stoi(dest.substr(colon + 1))));
+    }
+    receiver.set_relay(std::move(dests));
+  }
+  const bool parse = option("parse", "1") == "1";
+  const std::string worker_wait = option("worker_wait", "condvar");
+  rtp::Receiver::WorkerWait wait_mode;
+  if (worker_wait == "condvar") {
+    wait_mode = rtp::Receiver::WorkerWait::kCondvar;
+  } else if (worker_wait == "spin") {
+    wait_mode = rtp::Receiver::WorkerWait::kSpin;
+  } else if (worker_wait == "spinpark") {
+    wait_mode = rtp::Receiver::WorkerWait::kSpinPark;
+  } else if (worker_wait == "eventfd") {
+    wait_mode = rtp::Receiver::WorkerWait::kEventfd;
+  } else {
+    std::cerr << "Unknown worker wait strategy: " << worker_wait << std::endl;
+    return EXIT_FAILURE;
+  }
+  receiver.set_worker_wait(wait_mode, std::stoul(option("worker_spin", "4096")));
+  receiver.set_busy_poll(std::stoi(option("busy_poll", "0")), option("busy_poll_prefer", "0") == "1",
+                         std::stoi(option("busy_poll_budget", "0")));
+  rtp::Receiver::Capacity capacity;
+  capacity.slabs        = std::stoul(option("slabs", "0"));
+  capacity.bitrate_mbps = std::stod(option("bitrate_mbps", "0"));
+  capacity.frame_rate   = std::stod(option("fps", "60"));
+  capacity.hold_ms      = std::stod(option("hold_ms", "200"));
+  capacity.packet_bytes = std::stoul(option("pkt_bytes", "1400"));
+  capacity.max_datagram = std::stoul(option("max_datagram", "9216"));
+  receiver.set_capacity(capacity);
+  const std::string slab_pages = option("slab_pages", "thp");
+  rtp::Receiver::SlabPages pages_mode;
+  if (slab_pages == "small") {
+    pages_mode = rtp::Receiver::SlabPages::kSmall;
+  } else if (slab_pages == "thp") {
+    pages_mode = rtp::Receiver::SlabPages::kThp;
+  } else if (slab_pages == "hugetlb") {
+    pages_mode = rtp::Receiver::SlabPages::kHugeTlb;
+  } else {
+    std::cerr << "Unknown slab page mode: " << slab_pages << std::endl;
+    return EXIT_FAILURE;
+  }
+  receiver.set_slab_memory(pages_mode, option("slab_lock", "0") == "1", option("slab_prefault", "1") == "1");
+  const bool run_to_completion = option("rtc", "0") == "1";
+  receiver.set_run_to_completion(run_to_completion,
+                                 static_cast<unsigned>(std::stoul(option("rtc_budget_us", "5000"))));
+
+  const size_t jitter_depth = std::stoul(option("jitter_depth", "64"));
+  const size_t jitter_max   = std::stoul(option("jitter_max", "0"));
+  receiver.set_jitter_depth(jitter_depth, jitter_max);
+  receiver.set_frame_admission(std::stod(option("admit", "0")));
 
   j2k::frame_handler frame_handler;
-  if (argc > 5) {
+  if (nargs > 5) {
     const uint32_t HOLDBACK = static_cast<uint32_t>(std::stoul(argv[5]));
     frame_handler.set_parse_holdback(HOLDBACK);
   }
   std::cout << "Parse hold-back: " << frame_handler.get_parse_holdback() << " precincts" << std::endl;
   std::cout << "Recv pin: " << (recv_cpu < 0 ? "off" : ("CPU " + std::to_string(recv_cpu)))
             << ", Worker pin: " << (worker_cpu < 0 ? "off" : ("CPU " + std::to_string(worker_cpu)))
-            << ", SO_RCVBUF: " << recv_buf_mb << " MB" << std::endl;
+            << ", SO_RCVBUF: " << recv_buf_mb << " MB, recv batch: " << recv_batch << ", ingest: " << ingest
+            << ", sockets: " << recv_sockets << ", worker wait: " << worker_wait
+            << ", run to completion: " << (run_to_completion ? "on" : "off") << ", jitter depth: " << jitter_depth;
+  if (jitter_max > jitter_depth) std::cout << "-" << jitter_max << " (adaptive)";
+  if (!redundant.empty()) std::cout << ", redundant path: " << redundant;
+  if (!fec.empty()) std::cout << ", FEC port(s): " << fec;
+  if (!nack.empty()) std::cout << ", NACK to: " << nack;
+  if (!srtp.empty())
+    std::cout << ", SRTP: " << srtp.substr(0, srtp.find(':')) << " (" << rtp::srtp::backend() << ")";
+  if (!relay.empty()) std::cout << ", relay to: " << relay;
+  if (!parse) std::cout << ", parsing: off";
+  std::cout << std::endl;
+  frame_handler.set_held_slab_cap(receiver.held_slab_cap());
+  std::cout << "Slab pool: " << receiver.slab_count() << " slabs (" << receiver.pool_bytes() / (1024 * 1024)
+            << " MB), held-slab cap: " << frame_handler.get_held_slab_cap() << std::endl;
   check_nic_irq_affinity(LOCAL_ADDRESS, recv_cpu, worker_cpu);
 
   // Wire slab-release: frame_handler holds slabs across each frame (zero-copy chain
   // parsing) and releases them via this callback at EOC.
   frame_handler.set_release_slab_callback(
       [](void *r, size_t idx) { static_cast<rtp::Receiver *>(r)->release_slab(idx); }, &receiver);
+  frame_handler.set_release_through_callback(
+      [](void *r, size_t idx) { static_cast<rtp::Receiver *>(r)->release_through(idx); }, &receiver);
 
   params_t params{};
-  params.frame_handler = &frame_handler;
-  params.receiver      = &receiver;
-  params.total_frames  = 0;
-  params.last_timetamp = 0;
-
-  if (!receiver.start(LOCAL_ADDRESS, LOCAL_PORT, &params, rtp_receive_hook)) {
+  params.frame_handler       = &frame_handler;
+  params.receiver            = &receiver;
+  params.total_frames        = 0;
+  params.last_timetamp       = 0;
+  params.last_recv_calls     = 0;
+  params.last_recv_datagrams = 0;
+  params.last_worker_wakeups = 0;
+  params.last_worker_spins   = 0;
+  params.last_inline_frames  = 0;
+  params.last_handoff_frames = 0;
+  params.multi_socket        = (recv_sockets > 1 && ingest == "socket") || !redundant.empty();
+  params.dual_path           = !redundant.empty();
+  params.fec                 = !fec.empty();
+  params.nack                = !nack.empty();
+  params.srtp                = !srtp.empty();
+  params.relay               = !relay.empty();
+  params.parse               = parse;
+  params.run_to_completion   = run_to_completion;
+  params.adaptive_jitter     = jitter_max > jitter_depth;
+  params.shed_levels         = static_cast<uint8_t>(std::stoul(option("shed_levels", "0")));
+  params.shed_backlog        = std::stoul(option("shed_backlog", "2048"));
+
+  RtpSink sink{&params};
+  ReleaseSink release_sink{&params};
+  const bool started = parse ? receiver.start(LOCAL_ADDRESS, LOCAL_PORT, sink)
+                             : receiver.start(LOCAL_ADDRESS, LOCAL_PORT, release_sink);
+  if (!started) {
     std::cerr << "Failed to start RTP receiver" << std::endl;
     return EXIT_FAILURE;
   }
@@ -238,17 +572,12 @@ int main(int argc, char *argv[]) {
   return EXIT_SUCCESS;
 }
 
-static void rtp_receive_hook(void *arg, const rtp::Frame &frame) {
-  const auto p           = static_cast<struct params_t *>(arg);
+static void print_stats(params_t *p, uint32_t timestamp) {
   j2k::frame_handler *fh = p->frame_handler;
-  fh->pull_data(frame.payload, frame.payload_len - 8, frame.marker, frame.slab_idx);
 
-  size_t last_processed_frames = fh->get_total_frames();
-  if (p->last_timetamp == 0) {
-    p->last_timetamp = frame.timestamp;
-  }
-  if (frame.timestamp >= p->last_timetamp + 45000) {
-    const double frames_in_window = static_cast<double>(last_processed_frames - p->total_frames);
+  const size_t last_processed_frames = fh->get_total_frames();
+  const double frames_in_window      = static_cast<double>(last_processed_frames - p->total_frames);
+  if (p->parse) {
     std::cout << "Elapsed time: " << std::left << std::setw(8) << std::right << std::fixed
               << std::setprecision(3)
               << (fh->get_cumlative_time_then_reset() / 1000.0 / frames_in_window) << " [ms/frame], ";
@@ -256,37 +585,112 @@ static void rtp_receive_hook(void *arg, const rtp::Frame &frame) {
     std::cout << "Processed frames: " << std::setw(7) << last_processed_frames << ", " << std::setw(7)
               << std::fixed << std::setprecision(4)
               << (1000.0 * frames_in_window / fh->get_duration()) << " fps, "
-              << "trunc J2K frames = " << std::setw(5) << fh->get_trunc_frames() << ", "
-              << "RTP drops: net=" << std::setw(5) << p->receiver->net_lost_packets()
-              << " busy=" << std::setw(5) << p->receiver->slot_busy_drops()
-              << " qfull=" << std::setw(5) << p->receiver->queue_full_drops() << std::endl;
+              << "trunc J2K frames = " << std::setw(5) << fh->get_trunc_frames() << ", ";
+  }
+  std::cout << "RTP drops: net=" << std::setw(5) << p->receiver->net_lost_packets()
+            << " busy=" << std::setw(5) << p->receiver->slot_busy_drops()
+            << " qfull=" << std::setw(5) << p->receiver->queue_full_drops();
+  // Relay fan-out since start: datagrams sent over all destinations, and those a full
+  // socket buffer refused.
+  if (p->relay)
+    std::cout << ", relay: sent=" << p->receiver->relay_packets() << " drop=" << p->receiver->relay_drops();
+  if (const size_t resyncs = p->receiver->resyncs()) std::cout << ", resync=" << resyncs;
+  if (const size_t shed = p->receiver->shed_frames())
+    std::cout << ", shed=" << shed << " (" << p->receiver->shed_packets() << " pkts)";
+  if (const size_t res_shed = fh->get_shed_frames()) std::cout << ", res_shed=" << res_shed;
+  // Average recvmmsg fill over this interval (1.0 with recv_batch=1).
+  const size_t calls   = p->receiver->recv_calls();
+  const size_t dgrams  = p->receiver->recv_datagrams();
+  const size_t d_calls = calls - p->last_recv_calls;
+  std::cout << ", batch=" << std::fixed << std::setprecision(1)
+            << (d_calls ? static_cast<double>(dgrams - p->last_recv_datagrams) / static_cast<double>(d_calls)
+                        : 0.0);
+  if (p->multi_socket) std::cout << ", merge=" << p->receiver->merge_drops();
+  // Worker sleeps and idle spin polls (thousands) over this interval.
+  const size_t wakeups = p->receiver->worker_wakeups();
+  const size_t spins   = p->receiver->worker_spins();
+  std::cout << ", wake=" << (wakeups - p->last_worker_wakeups) << " spin=" << (spins - p->last_worker_spins) / 1000
+            << "k" << std::endl;
+  p->last_recv_calls     = calls;
+  p->last_recv_datagrams = dgrams;
+  p->last_worker_wakeups = wakeups;
+  p->last_worker_spins   = spins;
+  if (p->run_to_completion) {
+    // Frames parsed on the recv thread / handed to the worker over this interval.
+    const size_t inl     = p->receiver->inline_frames();
+    const size_t handoff = p->receiver->handoff_frames();
+    std::cout << "  Run to completion: inline=" << (inl - p->last_inline_frames)
+              << " handoff=" << (handoff - p->last_handoff_frames)
+              << " fallbacks=" << p->receiver->rtc_fallbacks() << std::endl;
+    p->last_inline_frames  = inl;
+    p->last_handoff_frames = handoff;
+  }
+  if (p->dual_path) {
+    // Per network since start: each path's own loss, which the other covered unless it
+    // shows in net=; and how much later path 1's copies arrive.
+    rtp::Receiver *rx = p->receiver;
+    std::cout << "  Paths: 0 pkts=" << rx->path_packets(0) << " lost=" << rx->path_lost(0)
+              << ", 1 pkts=" << rx->path_packets(1) << " lost=" << rx->path_lost(1) << ", skew=" << rx->path_skew_us()
+              << " us (max " << rx->path_skew_max_us() << " us)" << std::endl;
+  }
+  if (p->fec) {
+    std::cout << "  FEC: parity=" << p->receiver->fec_packets() << " recovered=" << p->receiver->fec_recovered()
+              << " unrecoverable=" << p->receiver->fec_unrecoverable() << std::endl;
+  }
+  if (p->nack) {
+    std::cout << "  NACK: requested=" << p->receiver->nack_requested() << " recovered=" << p->receiver->rtx_recovered()
+              << " late=" << p->receiver->rtx_late() << " expired=" << p->receiver->nack_expired() << std::endl;
+  }
+  if (p->srtp) {
+    std::cout << "  SRTP: auth_fail=" << p->receiver->srtp_auth_failures()
+              << " replay=" << p->receiver->srtp_replays() << std::endl;
+  }
+  // Reordering since start, by distance behind the newest packet (only buckets that
+  // were hit), and the jitter depth it has driven the ring to.
+  const auto reorder = p->receiver->reorder_histogram();
+  size_t reordered   = 0;
+  for (const size_t n : reorder) reordered += n;
+  if (p->adaptive_jitter || reordered) {
+    std::cout << "  Jitter: depth=" << p->receiver->jitter_depth() << " late=" << p->receiver->late_packets()
+              << " reorder";
+    for (size_t b = 0; b < reorder.size(); ++b) {
+      if (!reorder[b]) continue;
+      std::cout << ' ' << (size_t{1} << b);
+      if (b + 1 == reorder.size()) {
+        std::cout << '+';
+      } else if (b > 0) {
+        std::cout << '-' << (size_t{2} << b) - 1;
+      }
+      std::cout << ':' << reorder[b];
+    }
+    std::cout << std::endl;
+  }
 #ifdef PARSER_OVERSHOOT_INSTR
-    const auto os = fh->get_overshoot_stats();
-    const double avg_prec_bytes =
-        os.precincts_parsed
-            ? static_cast<double>(os.sum_precinct_bytes) / static_cast<double>(os.precincts_parsed)
-            : 0.0;
-    const double avg_drift =
-        os.snaps_with_drift
-            ? static_cast<double>(os.sum_drift_bytes) / static_cast<double>(os.snaps_with_drift)
-            : 0.0;
-    std::cout << "  Parser: precincts=" << os.precincts_parsed
-              << " avg_prec_bytes=" << std::fixed << std::setprecision(1) << avg_prec_bytes
-              << " drift_snaps=" << os.snaps_with_drift << " max_drift_bytes=" << os.max_drift_bytes
-              << " mean_drift=" << std::fixed << std::setprecision(1) << avg_drift
-              << " recoveries=" << os.recoveries << " skipped_precincts=" << os.skipped_precincts
+  const auto os = fh->get_overshoot_stats();
+  const double avg_prec_bytes =
+      os.precincts_parsed
+          ? static_cast<double>(os.sum_precinct_bytes) / static_cast<double>(os.precincts_parsed)
+          : 0.0;
+  const double avg_drift =
+      os.snaps_with_drift
+          ? static_cast<double>(os.sum_drift_bytes) / static_cast<double>(os.snaps_with_drift)
+          : 0.0;
+  std::cout << "  Parser: precincts=" << os.precincts_parsed
+            << " avg_prec_bytes=" << std::fixed << std::setprecision(1) << avg_prec_bytes
+            << " drift_snaps=" << os.snaps_with_drift << " max_drift_bytes=" << os.max_drift_bytes
+            << " mean_drift=" << std::fixed << std::setprecision(1) << avg_drift
+            << " recoveries=" << os.recoveries << " skipped_precincts=" << os.skipped_precincts
+            << std::endl;
+  if (os.failed_parses) {
+    std::cout << "  Failures: count=" << os.failed_parses
+              << " recover_fail: no_sig=" << os.recover_no_signal
+              << " bad_pid=" << os.recover_bad_pid << " backward=" << os.recover_backward
+              << " last={c=" << os.last_fail_c << " r=" << os.last_fail_r << " p=" << os.last_fail_p
+              << " crp_idx=" << os.last_fail_crp_idx << " src=" << os.last_fail_src_pos << "}"
               << std::endl;
-    if (os.failed_parses) {
-      std::cout << "  Failures: count=" << os.failed_parses
-                << " recover_fail: no_sig=" << os.recover_no_signal
-                << " bad_pid=" << os.recover_bad_pid << " backward=" << os.recover_backward
-                << " last={c=" << os.last_fail_c << " r=" << os.last_fail_r << " p=" << os.last_fail_p
-                << " crp_idx=" << os.last_fail_crp_idx << " src=" << os.last_fail_src_pos << "}"
-                << std::endl;
-    }
-    fh->reset_overshoot_stats();
-#endif
-    p->total_frames  = last_processed_frames;
-    p->last_timetamp = frame.timestamp;
   }
+  fh->reset_overshoot_stats();
+#endif
+  p->total_frames  = last_processed_frames;
+  p->last_timetamp = timestamp;
 }
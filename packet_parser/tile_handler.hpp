@@ -84,6 +84,12 @@ class tile_handler {
   // Used by try_recover() to map a signaled PID to a position in the parser's CRP order.
   std::vector<std::vector<uint32_t>> crp_idx_by_pid_;
 
+  // Resolution shedding (set_shed_levels): the number of highest resolution levels not
+  // parsed this frame, and a bit per resolution level that lost precincts this frame —
+  // shed, or skipped by try_recover().
+  uint8_t shed_levels_        = 0;
+  uint32_t incomplete_levels_ = 0;
+
 #ifdef PARSER_OVERSHOOT_INSTR
   OvershootStats ostats_;
 #endif
@@ -114,6 +120,17 @@ class tile_handler {
   void set_parse_holdback(uint32_t n) { parse_holdback_ = n; }
   uint32_t get_parse_holdback() const { return parse_holdback_; }
 
+  // Load shedding by resolution: precincts in each component's n highest resolution
+  // levels (never level 0) are not parsed. The walk jumps from such a precinct to the
+  // next signaled one it keeps, so their packet headers are never read and no precinct
+  // callback fires for them; unsignaled precincts jumped over on the way are lost too
+  // and show up in incomplete_levels(). Takes effect at the next precinct — set it at a
+  // frame boundary. 0 parses everything.
+  void set_shed_levels(uint8_t n) { shed_levels_ = n; }
+  uint8_t get_shed_levels() const { return shed_levels_; }
+  // Resolution levels (bit r = level r) missing precincts in the current frame.
+  uint32_t incomplete_levels() const { return incomplete_levels_; }
+
   // Called by frame_handler each time a body packet with ORDB=1 arrives. byte_offset is
   // the absolute position in incoming_data of the resync point (start of the precinct
   // identified by pid's packet header). Entries arrive in byte order. PID is needed by
@@ -227,6 +244,10 @@ class tile_handler {
       if (static_cast<uint32_t>(tile->buf->get_pos()) >= signal_queue_.back().byte_offset) break;
 
       const crp_status ct = tile->crp[tile->crp_idx];
+      if (is_shed(ct)) {
+        if (skip_shed(tile)) continue;
+        break;  // the next kept precinct's signal has not arrived yet
+      }
 #ifdef PARSER_OVERSHOOT_INSTR
       const size_t before_pos = tile->buf->get_pos();
       tile->buf->reset_max_offset_read();
@@ -264,6 +285,16 @@ class tile_handler {
     const int n = static_cast<int>(tile->crp.size());
     for (; tile->crp_idx < n; tile->crp_idx++) {
       const crp_status ct = tile->crp[tile->crp_idx];
+      if (is_shed(ct)) {
+        if (!skip_shed(tile)) {
+          // No signal ahead: the rest of the frame cannot be reached without parsing.
+          mark_incomplete(tile, static_cast<uint32_t>(n));
+          tile->crp_idx = n;
+          break;
+        }
+        tile->crp_idx--;  // skip_shed set it; undo the for-loop's ++
+        continue;
+      }
 #ifdef PARSER_OVERSHOOT_INSTR
       const size_t before_pos = tile->buf->get_pos();
       tile->buf->reset_max_offset_read();
@@ -328,18 +359,14 @@ class tile_handler {
 #endif
       return false;
     }
-    const Signal sig  = signal_queue_.front();
-    const uint32_t nc = static_cast<uint32_t>(siz.Csiz);
-    if (nc == 0) return false;
-    const uint32_t c = sig.pid % nc;
-    const uint32_t s = sig.pid / nc;
-    if (c >= crp_idx_by_pid_.size() || s >= crp_idx_by_pid_[c].size()) {
+    const Signal sig     = signal_queue_.front();
+    uint32_t new_crp_idx = 0;
+    if (!crp_idx_of(sig.pid, &new_crp_idx)) {
 #ifdef PARSER_OVERSHOOT_INSTR
       ostats_.recover_bad_pid++;
 #endif
       return false;
     }
-    const uint32_t new_crp_idx = crp_idx_by_pid_[c][s];
     // Accept new_crp_idx == current (resume at the same precinct from a corrected
     // position) or > current (skip ahead). Reject only if it would move backward —
     // walking past backward signals to find a forward one was tested and didn't help
@@ -354,12 +381,58 @@ class tile_handler {
     ostats_.recoveries++;
     ostats_.skipped_precincts += new_crp_idx - tile->crp_idx;
 #endif
+    mark_incomplete(tile, new_crp_idx);
     tile->buf->reset(sig.byte_offset);
     tile->crp_idx = static_cast<int>(new_crp_idx);
     signal_queue_.pop_front();  // we're now AT this signal; consume it
     return true;
   }
 
+  // crp_idx of the precinct a signaled PID (= c + s*num_components) identifies.
+  bool crp_idx_of(uint32_t pid, uint32_t *crp_idx) const {
+    const uint32_t nc = static_cast<uint32_t>(siz.Csiz);
+    if (nc == 0) return false;
+    const uint32_t c = pid % nc;
+    const uint32_t s = pid / nc;
+    if (c >= crp_idx_by_pid_.size() || s >= crp_idx_by_pid_[c].size()) return false;
+    *crp_idx = crp_idx_by_pid_[c][s];
+    return true;
+  }
+
+  bool is_shed(const crp_status &ct) const {
+    return shed_levels_ && ct.r > 0 && ct.r + shed_levels_ > cocs[ct.c].NL;
+  }
+
+  // Precincts [crp_idx, end) get no callback this frame.
+  void mark_incomplete(const tile_ *tile, uint32_t end) {
+    for (uint32_t i = static_cast<uint32_t>(tile->crp_idx); i < end; ++i) incomplete_levels_ |= 1u << tile->crp[i].r;
+  }
+
+  // The precinct at crp_idx is shed: jump without parsing to the first signal ahead that
+  // starts a kept precinct, or — none yet — to the farthest signal ahead (a shed
+  // precinct), so the next call starts from there. Same mechanics as try_recover().
+  // Returns false if no usable signal lies ahead.
+  bool skip_shed(tile_ *tile) {
+    const uint32_t cur_pos = static_cast<uint32_t>(tile->buf->get_pos());
+    while (!signal_queue_.empty() && signal_queue_.front().byte_offset <= cur_pos) {
+      signal_queue_.pop_front();
+    }
+    size_t target       = signal_queue_.size();
+    uint32_t target_crp = 0;
+    for (size_t i = 0; i < signal_queue_.size(); ++i) {
+      uint32_t idx = 0;
+      if (!crp_idx_of(signal_queue_[i].pid, &idx) || idx < static_cast<uint32_t>(tile->crp_idx)) continue;
+      target     = i;
+      target_crp = idx;
+      if (!is_shed(tile->crp[idx])) break;
+    }
+    if (target == signal_queue_.size()) return false;
+    mark_incomplete(tile, target_crp);
+    tile->buf->reset(signal_queue_[target].byte_offset);
+    tile->crp_idx = static_cast<int>(target_crp);
+    return true;
+  }
+
 #ifdef PARSER_OVERSHOOT_INSTR
   void record_precinct(codestream *buf, size_t before_pos) {
     const size_t after_pos = buf->get_pos();
@@ -385,6 +458,7 @@ class tile_handler {
     // we do NOT call tile->buf->reset here — the chain is empty at this point and
     // setting cur_offset_ without chunks would leave it in an inconsistent state.
     signal_queue_.clear();
+    incomplete_levels_ = 0;
     // Bound by tiles.size(), not num_tiles_x*num_tiles_y: a create() that fails partway
     // (e.g. unsupported progression) leaves fewer tiles built than the grid implies, and
     // restart() can run at EOC on that partial build. For a fully-built stream the two
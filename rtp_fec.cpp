@@ -0,0 +1,333 @@
+// SMPTE 2022-1 forward error correction for rtp::Receiver (set_fec).
+//
+// The sender protects the media stream with XOR parity packets (RFC 2733 protection
+// operation, 2022-1 FEC header) sent to a companion port: a column packet covers L
+// media packets spaced L apart, a row packet L consecutive ones. Any one packet of a
+// group can be rebuilt from the parity and the rest of the group.
+//
+// A FEC thread receives the parity packets and hands them to the recv thread on an SPSC
+// queue. The recv thread keeps a copy of every media packet it accepts in a history ring
+// (the slabs themselves may already be back with the worker, or released, by the time a
+// column's parity arrives), and at the start of each handle_dgram it drains the queue and
+// tries the parity it holds. A group with exactly one packet missing is rebuilt into a
+// fresh slab and passed to handle_dgram, so it lands in its jitter ring slot as if it had
+// arrived; being stored in the history in turn, it can complete a group of the other
+// dimension. Parity is kept until the ring has given up on its group; packets still
+// missing then count as unrecoverable.
+#include "rtp_receiver.hpp"
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "rtp_wire.hpp"
+
+namespace rtp {
+
+namespace {
+
+constexpr size_t kFecHeader    = 16;   // after the parity packet's 12-byte RTP header
+constexpr size_t kFecQueueSize = 256;  // parity packets in flight, FEC thread -> recv thread
+constexpr size_t kFecPending   = 256;  // parity held for groups not yet complete
+// 2022-1 limits a matrix to L x D <= 100 packets; a column group spans up to that, and its
+// parity follows the matrix.
+constexpr size_t kFecMaxSpan = 100;
+// Media history entries beyond the jitter window: room for a group's span plus its parity
+// latency.
+constexpr size_t kFecHistorySlack = 4 * kFecMaxSpan;
+// Packets between sweeps of the held parity when nothing new arrived: catches groups a
+// late (reordered) media packet completed, and expires the stale ones.
+constexpr uint16_t kFecSweep = 32;
+
+}  // namespace
+
+struct Receiver::FecState {
+  // Media packets are protected up to one slab, so a rebuilt packet fits a single slab.
+  static constexpr size_t kPayload    = kSlabBytes - 12;
+  static constexpr size_t kEntryBytes = 12 + kFecHeader + kPayload;
+
+  // A media packet as the protection operation sees it: the header fields it recovers and
+  // the bytes after the fixed 12-byte header (CSRCs, extension, payload, padding).
+  struct Stored {
+    bool present   = false;
+    bool given_up  = false;  // missing, already counted unrecoverable
+    uint16_t seq   = 0;
+    uint8_t b0     = 0;  // P, X, CC
+    uint8_t b1     = 0;  // M, PT
+    uint16_t len   = 0;
+    uint32_t stamp = 0;
+  };
+  struct Parity {
+    uint16_t base;
+    uint16_t end;  // last protected sequence number
+    uint8_t offset;
+    uint8_t count;
+    uint8_t b0, b1;  // P/X/CC and M recovery (the parity packet's own RTP header)
+    uint8_t pt;      // PT recovery
+    uint16_t len;    // length recovery
+    uint32_t stamp;  // TS recovery
+    uint16_t bytes;  // payload recovery length
+    uint8_t* payload;
+  };
+
+  int fds[2] = {-1, -1};
+  std::thread thread;
+
+  // SPSC queue, FEC thread -> recv thread: raw parity datagrams.
+  std::vector<uint8_t> queue;
+  std::vector<uint16_t> queue_len;
+  alignas(64) std::atomic<size_t> head{0};
+  alignas(64) std::atomic<size_t> tail{0};
+
+  // Recv thread only from here on.
+  std::vector<Stored> history;
+  std::vector<uint8_t> history_bytes;  // kPayload per entry
+  size_t history_mask = 0;
+  std::vector<Parity> pending;
+  std::vector<uint8_t*> free_payloads;
+  std::vector<uint8_t> payload_pool;  // kFecPending x kPayload
+  bool polling        = false;        // handle_dgram re-entered from a rebuild
+  uint16_t last_sweep = 0;
+
+  uint8_t* bytes_of(uint16_t seq) { return history_bytes.data() + (seq & history_mask) * kPayload; }
+
+  // Writes `seq`, the one packet of `par`'s group missing from the history, to `out` (a
+  // slab). Returns its length, 0 if the group's length recovery is inconsistent.
+  size_t rebuild(const Parity& par, uint16_t seq, uint32_t ssrc, uint8_t* out) {
+    uint8_t b0       = par.b0;
+    uint8_t b1       = par.b1;
+    uint8_t pt       = par.pt;
+    uint16_t len     = par.len;
+    uint32_t stamp   = par.stamp;
+    uint8_t* payload = out + 12;
+    std::memcpy(payload, par.payload, par.bytes);
+    std::memset(payload + par.bytes, 0, kPayload - par.bytes);
+    for (unsigned k = 0; k < par.count; ++k) {
+      const uint16_t s = static_cast<uint16_t>(par.base + k * par.offset);
+      if (s == seq) continue;
+      const Stored& m = history[s & history_mask];
+      b0 ^= m.b0;
+      b1 ^= m.b1 & 0x80;
+      pt ^= m.b1 & 0x7F;
+      len ^= m.len;
+      stamp ^= m.stamp;
+      const uint8_t* bytes = bytes_of(s);
+      for (size_t b = 0; b < m.len; ++b) payload[b] ^= bytes[b];
+    }
+    if (len > kPayload) return 0;
+    out[0] = static_cast<uint8_t>(0x80 | b0);
+    out[1] = static_cast<uint8_t>(b1 | pt);
+    out[2] = static_cast<uint8_t>(seq >> 8);
+    out[3] = static_cast<uint8_t>(seq);
+    for (int i = 0; i < 4; ++i) {
+      out[4 + i] = static_cast<uint8_t>(stamp >> (24 - 8 * i));
+      out[8 + i] = static_cast<uint8_t>(ssrc >> (24 - 8 * i));
+    }
+    return 12 + size_t{len};
+  }
+};
+
+bool Receiver::open_fec(const sockaddr_in& addr) {
+  fec_                    = new FecState;
+  FecState& f             = *fec_;
+  const uint16_t ports[2] = {fec_port_, fec_row_port_};
+  for (int i = 0; i < 2; ++i) {
+    if (!ports[i]) continue;
+    sockaddr_in a = addr;
+    a.sin_port    = htons(ports[i]);
+    f.fds[i]      = open_udp_socket(a, false);
+    if (f.fds[i] < 0) {
+      close_fec();
+      return false;
+    }
+  }
+  f.queue.assign(kFecQueueSize * FecState::kEntryBytes, 0);
+  f.queue_len.assign(kFecQueueSize, 0);
+
+  // The ring gives up on a packet jitter_hi_ behind the newest; parity older than that
+  // is useless, so the history only has to reach back that far plus a group's span.
+  size_t entries = 1;
+  while (entries < jitter_hi_ + kFecHistorySlack) entries <<= 1;
+  f.history.assign(entries, FecState::Stored{});
+  f.history_bytes.assign(entries * FecState::kPayload, 0);
+  f.history_mask = entries - 1;
+  f.payload_pool.assign(kFecPending * FecState::kPayload, 0);
+  f.pending.reserve(kFecPending);
+  for (size_t i = 0; i < kFecPending; ++i)
+    f.free_payloads.push_back(f.payload_pool.data() + i * FecState::kPayload);
+  return true;
+}
+
+void Receiver::start_fec() {
+  fec_->thread = std::thread([this] { fec_loop(); });
+}
+
+void Receiver::stop_fec() {
+  if (!fec_) return;
+  for (int fd : fec_->fds)
+    if (fd >= 0) ::shutdown(fd, SHUT_RD);
+  if (fec_->thread.joinable()) fec_->thread.join();
+}
+
+void Receiver::close_fec() {
+  if (!fec_) return;
+  for (int fd : fec_->fds)
+    if (fd >= 0) ::close(fd);
+  delete fec_;
+  fec_ = nullptr;
+}
+
+void Receiver::fec_loop() {
+  FecState& f = *fec_;
+  pollfd pfd[2];
+  nfds_t n = 0;
+  for (int fd : f.fds) {
+    if (fd >= 0) pfd[n++] = pollfd{fd, POLLIN, 0};
+  }
+  while (running_.load(std::memory_order_acquire)) {
+    if (::poll(pfd, n, 100) <= 0) continue;  // the timeout re-checks running_
+    for (nfds_t i = 0; i < n; ++i) {
+      if (!(pfd[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+      const size_t tail = f.tail.load(std::memory_order_relaxed);
+      if (tail - f.head.load(std::memory_order_acquire) >= kFecQueueSize) {
+        // Recv thread is a whole queue behind (or idle: no media): drop the parity.
+        uint8_t sink;
+        ::recv(pfd[i].fd, &sink, sizeof(sink), MSG_DONTWAIT);
+        continue;
+      }
+      uint8_t* entry  = f.queue.data() + (tail % kFecQueueSize) * FecState::kEntryBytes;
+      const ssize_t r = ::recv(pfd[i].fd, entry, FecState::kEntryBytes, MSG_DONTWAIT | MSG_TRUNC);
+      if (r < 0 || static_cast<size_t>(r) > FecState::kEntryBytes || static_cast<size_t>(r) < 12 + kFecHeader)
+        continue;
+      f.queue_len[tail % kFecQueueSize] = static_cast<uint16_t>(r);
+      f.tail.store(tail + 1, std::memory_order_release);
+      fec_packets_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+// Recv thread, for every packet handle_dgram accepts into the jitter ring.
+void Receiver::fec_store(uint16_t seq, const uint8_t* data, size_t len) {
+  FecState& f         = *fec_;
+  FecState::Stored& s = f.history[seq & f.history_mask];
+  const size_t bytes  = len - 12;
+  s.seq               = seq;
+  s.given_up          = false;
+  s.present           = bytes <= FecState::kPayload;  // larger packets are not protected
+  if (!s.present) return;
+  s.b0    = data[0] & 0x3F;
+  s.b1    = data[1];
+  s.len   = static_cast<uint16_t>(bytes);
+  s.stamp = rd_u32(data + 4);
+  std::memcpy(f.bytes_of(seq), data + 12, bytes);
+}
+
+// Recv thread, at the top of handle_dgram: takes in new parity, then tries every held
+// parity packet whose group has been fully sent, rebuilding until no group changes.
+void Receiver::fec_poll() {
+  FecState& f = *fec_;
+  if (f.polling) return;
+  bool fresh        = false;
+  const size_t tail = f.tail.load(std::memory_order_acquire);
+  size_t head       = f.head.load(std::memory_order_relaxed);
+  for (; head != tail; ++head) {
+    const uint8_t* p = f.queue.data() + (head % kFecQueueSize) * FecState::kEntryBytes;
+    const size_t len = f.queue_len[head % kFecQueueSize];
+    const uint8_t* h = p + 12;
+    // 2022-1 header: SNBase, length recovery, E|PT recovery, mask, TS recovery,
+    // N|D|type|index, offset, NA, SNBase extension.
+    const uint8_t type   = (h[12] >> 3) & 0x7;
+    const uint8_t offset = h[13];
+    const uint8_t count  = h[14];
+    if ((p[0] >> 6) != kRtpVersion || type != 0 || !offset || !count
+        || size_t{offset} * (count - 1u) >= kFecMaxSpan || f.free_payloads.empty())
+      continue;
+    FecState::Parity par;
+    par.base    = rd_u16(h);
+    par.end     = static_cast<uint16_t>(par.base + offset * (count - 1u));
+    par.offset  = offset;
+    par.count   = count;
+    par.b0      = p[0] & 0x3F;
+    par.b1      = p[1] & 0x80;
+    par.pt      = h[4] & 0x7F;
+    par.len     = rd_u16(h + 2);
+    par.stamp   = rd_u32(h + 8);
+    par.bytes   = static_cast<uint16_t>(std::min(len - 12 - kFecHeader, FecState::kPayload));
+    par.payload = f.free_payloads.back();
+    f.free_payloads.pop_back();
+    std::memcpy(par.payload, h + kFecHeader, par.bytes);
+    f.pending.push_back(par);
+    fresh = true;
+  }
+  f.head.store(head, std::memory_order_release);
+  if (f.pending.empty()) return;
+  if (!fresh && static_cast<uint16_t>(high_seq_ - f.last_sweep) < kFecSweep) return;
+  f.last_sweep = high_seq_;
+
+  f.polling       = true;
+  const int depth = static_cast<int>(jitter_depth_.load(std::memory_order_relaxed));
+  for (bool progress = true; progress;) {
+    progress = false;
+    for (size_t i = 0; i < f.pending.size();) {
+      FecState::Parity& par = f.pending[i];
+      const int16_t age     = static_cast<int16_t>(high_seq_ - par.end);
+      if (age < 0) {  // the group is still being sent
+        ++i;
+        continue;
+      }
+      size_t missing    = 0;
+      uint16_t lost_seq = 0;
+      for (unsigned k = 0; k < par.count; ++k) {
+        const uint16_t seq        = static_cast<uint16_t>(par.base + k * par.offset);
+        const FecState::Stored& s = f.history[seq & f.history_mask];
+        if (!(s.present && s.seq == seq)) {
+          ++missing;
+          lost_seq = seq;
+        }
+      }
+      bool done = missing == 0;
+      // Once the ring has delivered past the hole, the expiry below accounts for it.
+      if (missing == 1 && static_cast<int16_t>(next_seq_ - lost_seq) <= 0) {
+        const size_t slab = acquire_slab();
+        if (slab != kNoSlab) {  // else keep the parity and retry on a later sweep
+          const size_t len = f.rebuild(par, lost_seq, ssrc_, slab_ptr(slab));
+          if (len && handle_dgram(slab_ptr(slab), len, slab)) {
+            fec_recovered_.fetch_add(1, std::memory_order_relaxed);
+          } else {
+            free_slab(slab);
+          }
+          done     = true;
+          progress = true;
+        }
+      }
+      if (!done && age >= depth) {
+        // The ring has given up on this group: whatever is still missing stays lost.
+        for (unsigned k = 0; k < par.count; ++k) {
+          const uint16_t seq  = static_cast<uint16_t>(par.base + k * par.offset);
+          FecState::Stored& s = f.history[seq & f.history_mask];
+          if ((s.present || s.given_up) && s.seq == seq) continue;
+          s          = FecState::Stored{};
+          s.seq      = seq;
+          s.given_up = true;
+          fec_unrecoverable_.fetch_add(1, std::memory_order_relaxed);
+        }
+        done = true;
+      }
+      if (done) {
+        f.free_payloads.push_back(par.payload);
+        par = f.pending.back();
+        f.pending.pop_back();
+      } else {
+        ++i;
+      }
+    }
+  }
+  f.polling = false;
+}
+
+}  // namespace rtp
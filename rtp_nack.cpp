@@ -0,0 +1,282 @@
+// RFC 4585 generic NACK + RFC 4588 retransmission for rtp::Receiver (set_retransmission).
+//
+// The recv thread notices a hole when a packet lands more than one past the newest
+// sequence number, and records each missing number in a FIFO with the time it was seen.
+// Once kNackReorder newer packets have arrived (plain reordering has had its chance) a
+// number still missing is requested: the recv thread puts it on an SPSC queue and pokes
+// the NACK thread through a non-blocking eventfd, and that thread packs the requests
+// into RTCP transport-layer feedback (PT 205, FMT 1: PID plus a 16-bit bitmask of the
+// following numbers) and sends them. The recv thread never makes a blocking call.
+//
+// When the ring would force-advance past a hole that was requested, it holds instead,
+// until the retransmission fills it or the hole's deadline passes (or the ring runs out
+// of room); the hole is then counted lost and skipped like any other. The request is
+// repeated once at half the deadline, in case it or the retransmission was lost.
+//
+// Retransmissions share the media socket, told apart by their payload type; handle_dgram
+// turns each back into the packet it carries (unwrap_rtx) before any sequence accounting.
+#include "rtp_receiver.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "rtp_wire.hpp"
+
+namespace rtp {
+
+namespace {
+
+constexpr size_t kNackQueueSize = 1024;  // requests in flight, recv thread -> NACK thread
+constexpr size_t kNackHoles     = 4096;  // missing sequence numbers tracked at once
+// Newer packets that must arrive before a missing one is requested: reordering within
+// this distance is not loss.
+constexpr int16_t kNackReorder = 3;
+// FCI entries per RTCP packet (each covers up to 17 sequence numbers).
+constexpr size_t kNackFciMax = 64;
+constexpr uint8_t kRtcpRtpfb = 205;
+constexpr uint8_t kFmtNack   = 1;
+
+}  // namespace
+
+struct Receiver::NackState {
+  // A sequence number found missing.
+  struct Hole {
+    uint16_t seq;
+    uint8_t requests;  // 0: not yet, 1: once, 2: repeated
+    int64_t seen_ns;
+  };
+
+  int fd  = -1;  // connected to the sender's feedback address
+  int efd = -1;  // recv thread -> NACK thread wakeup
+  std::thread thread;
+  uint32_t own_ssrc = 0;  // "SSRC of packet sender" in the feedback
+
+  // SPSC queue, recv thread -> NACK thread: (media SSRC << 16) | seq.
+  std::vector<uint64_t> queue;
+  alignas(64) std::atomic<size_t> head{0};
+  alignas(64) std::atomic<size_t> tail{0};
+
+  // Recv thread only from here on. holes[first, last) in sequence order, which is also the
+  // order they were seen in; [first, unsent) have been considered for a request and
+  // [first, repeat) for the repeat.
+  std::vector<Hole> holes;
+  size_t first     = 0;
+  size_t repeat    = 0;
+  size_t unsent    = 0;
+  size_t last      = 0;
+  int64_t deadline = 0;      // ns
+  bool wake        = false;  // something queued since the last eventfd write
+
+  Hole& at(size_t i) { return holes[i & (kNackHoles - 1)]; }
+  void pop() {
+    ++first;
+    repeat = std::max(repeat, first);
+    unsent = std::max(unsent, first);
+  }
+  // Queues a request for the NACK thread; false if the queue is full.
+  bool request(uint32_t ssrc, uint16_t seq) {
+    const size_t qt = tail.load(std::memory_order_relaxed);
+    if (qt - head.load(std::memory_order_acquire) >= kNackQueueSize) return false;
+    queue[qt % kNackQueueSize] = (uint64_t{ssrc} << 16) | seq;
+    tail.store(qt + 1, std::memory_order_release);
+    wake = true;
+    return true;
+  }
+};
+
+bool Receiver::open_nack() {
+  sockaddr_in dst{};
+  dst.sin_family = AF_INET;
+  dst.sin_port   = htons(nack_port_);
+  if (::inet_pton(AF_INET, nack_addr_.c_str(), &dst.sin_addr) != 1) {
+    std::cerr << "rtp::Receiver: inet_pton(" << nack_addr_ << ") failed" << std::endl;
+    return false;
+  }
+  nack_        = new NackState;
+  NackState& n = *nack_;
+  n.fd         = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (n.fd < 0 || ::connect(n.fd, reinterpret_cast<const sockaddr*>(&dst), sizeof(dst)) != 0) {
+    std::cerr << "rtp::Receiver: NACK socket: " << std::strerror(errno) << std::endl;
+    close_nack();
+    return false;
+  }
+  n.efd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (n.efd < 0) {
+    std::cerr << "rtp::Receiver: eventfd() failed: " << std::strerror(errno) << std::endl;
+    close_nack();
+    return false;
+  }
+  n.own_ssrc = std::random_device{}();
+  n.queue.assign(kNackQueueSize, 0);
+  n.holes.assign(kNackHoles, NackState::Hole{});
+  n.deadline = static_cast<int64_t>(nack_deadline_ms_ * 1e6);
+  return true;
+}
+
+void Receiver::start_nack() {
+  nack_->thread = std::thread([this] { nack_loop(); });
+}
+
+void Receiver::stop_nack() {
+  if (!nack_) return;
+  const uint64_t one = 1;
+  (void)!::write(nack_->efd, &one, sizeof(one));
+  if (nack_->thread.joinable()) nack_->thread.join();
+}
+
+void Receiver::close_nack() {
+  if (!nack_) return;
+  if (nack_->fd >= 0) ::close(nack_->fd);
+  if (nack_->efd >= 0) ::close(nack_->efd);
+  delete nack_;
+  nack_ = nullptr;
+}
+
+void Receiver::nack_loop() {
+  NackState& n = *nack_;
+  pollfd pfd{n.efd, POLLIN, 0};
+  uint8_t pkt[12 + 4 * kNackFciMax];
+  while (running_.load(std::memory_order_acquire)) {
+    if (::poll(&pfd, 1, 100) <= 0) continue;  // the timeout re-checks running_
+    uint64_t count;
+    (void)!::read(n.efd, &count, sizeof(count));
+    const size_t tail = n.tail.load(std::memory_order_acquire);
+    size_t head       = n.head.load(std::memory_order_relaxed);
+    // Requests arrive in sequence order, so consecutive ones pack into PID + bitmask.
+    size_t fci    = 0;
+    uint32_t ssrc = 0;
+    uint16_t pid  = 0;
+    uint16_t blp  = 0;
+    auto flush    = [&] {
+      if (fci == 0) return;
+      pkt[0] = static_cast<uint8_t>(0x80 | kFmtNack);
+      pkt[1] = kRtcpRtpfb;
+      wr_u16(pkt + 2, static_cast<uint16_t>(2 + fci));  // length in words, minus one
+      wr_u32(pkt + 4, n.own_ssrc);
+      wr_u32(pkt + 8, ssrc);
+      ::send(n.fd, pkt, 12 + 4 * fci, MSG_DONTWAIT);
+      fci = 0;
+    };
+    for (; head != tail; ++head) {
+      const uint64_t e     = n.queue[head % kNackQueueSize];
+      const uint32_t essrc = static_cast<uint32_t>(e >> 16);
+      const uint16_t seq   = static_cast<uint16_t>(e);
+      const int d          = static_cast<uint16_t>(seq - pid);
+      if (fci > 0 && essrc == ssrc && d >= 1 && d <= 16) {
+        blp = static_cast<uint16_t>(blp | (1u << (d - 1)));
+        wr_u16(pkt + 12 + 4 * (fci - 1) + 2, blp);
+        continue;
+      }
+      if (fci == kNackFciMax || (fci > 0 && essrc != ssrc)) flush();
+      ssrc = essrc;
+      pid  = seq;
+      blp  = 0;
+      wr_u16(pkt + 12 + 4 * fci, pid);
+      wr_u16(pkt + 12 + 4 * fci + 2, 0);
+      ++fci;
+    }
+    flush();
+    n.head.store(head, std::memory_order_release);
+  }
+}
+
+// Recv thread: `count` sequence numbers from `first` just went missing.
+void Receiver::nack_gap(uint16_t first, size_t count) {
+  NackState& n = *nack_;
+  // Holes the ring has moved past (filled, or given up on) are done with.
+  while (n.first != n.last && static_cast<int16_t>(n.at(n.first).seq - next_seq_) < 0) n.pop();
+  const int64_t now = now_ns();
+  for (size_t k = 0; k < count && n.last - n.first < kNackHoles; ++k)
+    n.at(n.last++) = NackState::Hole{static_cast<uint16_t>(first + k), 0, now};
+}
+
+// Recv thread, per accepted packet: requests the holes kNackReorder or more behind the
+// newest sequence number that are still missing, repeats the requests half a deadline
+// old, then wakes the NACK thread if anything was queued (here or by nack_hold).
+void Receiver::nack_issue() {
+  NackState& n = *nack_;
+  auto missing = [this](uint16_t seq) {
+    const Slot& s = ring_[seq & (ring_size_ - 1)];
+    return static_cast<int16_t>(seq - next_seq_) >= 0 && !(s.filled && s.seq == seq);
+  };
+  for (; n.unsent != n.last; ++n.unsent) {
+    NackState::Hole& h = n.at(n.unsent);
+    if (static_cast<int16_t>(high_seq_ - h.seq) < kNackReorder) break;
+    if (h.requests || !missing(h.seq)) continue;  // the ring got to it first, or it arrived
+    if (!n.request(ssrc_, h.seq)) break;          // retried on the next packet
+    h.requests = 1;
+    nack_requested_.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (n.repeat != n.unsent) {
+    const int64_t now = now_ns();
+    for (; n.repeat != n.unsent; ++n.repeat) {
+      NackState::Hole& h = n.at(n.repeat);
+      if (2 * (now - h.seen_ns) < n.deadline) break;
+      if (h.requests != 1 || !missing(h.seq)) continue;
+      if (!n.request(ssrc_, h.seq)) break;
+      h.requests = 2;
+    }
+  }
+  if (n.wake) {
+    n.wake             = false;
+    const uint64_t one = 1;
+    (void)!::write(n.efd, &one, sizeof(one));  // non-blocking; a full counter still wakes
+  }
+}
+
+// Recv thread, from the force-advance: `seq`, the ring's head, is missing. True to hold
+// the ring for it — it is tracked and its deadline has not passed (requested from here if
+// the ring reached it before kNackReorder newer packets did). `room` false: the window is
+// spent, give up regardless.
+bool Receiver::nack_hold(uint16_t seq, bool room) {
+  NackState& n = *nack_;
+  while (n.first != n.last && static_cast<int16_t>(n.at(n.first).seq - seq) < 0) n.pop();
+  if (n.first == n.last || n.at(n.first).seq != seq) return false;  // untracked: plain loss
+  NackState::Hole& h = n.at(n.first);
+  if (!room || now_ns() - h.seen_ns >= n.deadline) {
+    nack_expired_.fetch_add(1, std::memory_order_relaxed);
+    n.pop();
+    return false;
+  }
+  if (h.requests == 0 && n.request(ssrc_, seq)) {
+    h.requests = 1;
+    nack_requested_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+// Recv thread, on a resync: the old stream's holes will never be filled.
+void Receiver::nack_reset() {
+  NackState& n = *nack_;
+  n.first = n.repeat = n.unsent = n.last;
+}
+
+// Recv thread: rewrites an RFC 4588 retransmission in place into the packet it carries —
+// the original sequence number from the front of the payload, the media stream's SSRC and
+// payload type. False if it is too short to carry one.
+bool Receiver::unwrap_rtx(uint8_t* data, size_t& len) {
+  size_t hdr = 12 + 4u * (data[0] & 0x0F);
+  if ((data[0] & 0x10) && len >= hdr + 4) hdr += 4u + 4u * rd_u16(data + hdr + 2);
+  const size_t pad = (data[0] & 0x20) ? data[len - 1] : 0;
+  if (len < hdr + 2 + pad) return false;
+  const uint16_t osn = rd_u16(data + hdr);
+  std::memmove(data + hdr, data + hdr + 2, len - hdr - 2);
+  len -= 2;
+  data[1] = static_cast<uint8_t>((data[1] & 0x80) | media_pt_);
+  wr_u16(data + 2, osn);
+  wr_u32(data + 8, ssrc_);
+  return true;
+}
+
+}  // namespace rtp
@@ -0,0 +1,233 @@
+// AF_PACKET TPACKET_V3 ingest backend for rtp::Receiver (Receiver::Ingest::kPacketRing).
+//
+// The kernel copies every matching frame into a shared-memory block ring and retires a
+// block to user space when it is full or after ring_retire_ms_. The recv thread walks
+// retired blocks in order, hands each RTP datagram to handle_dgram, and returns the
+// block to the kernel — one poll() per idle period instead of one recv() per datagram,
+// and no socket-buffer queueing. A classic BPF filter in the kernel keeps only
+// unfragmented IPv4/UDP to our port, so other traffic on the interface never reaches
+// the ring.
+//
+// The UDP socket start() binds is kept, with a drop-all filter attached: it reserves
+// the port (no ICMP port-unreachable back to the sender) while the UDP layer discards
+// its copy of each datagram before queueing.
+//
+// Requires CAP_NET_RAW. Testable on loopback (`lo` sees each datagram twice, once as
+// PACKET_OUTGOING — skipped below) or a veth pair.
+#include "rtp_receiver.hpp"
+
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace rtp {
+
+namespace {
+
+// Interface owning `addr` (network order). Empty on failure or for INADDR_ANY, which
+// leaves the packet socket bound to all interfaces.
+std::string iface_for_addr(uint32_t addr) {
+  if (addr == htonl(INADDR_ANY)) return "";
+  ifaddrs* ifs = nullptr;
+  if (::getifaddrs(&ifs) != 0) return "";
+  std::string result;
+  for (ifaddrs* it = ifs; it != nullptr; it = it->ifa_next) {
+    if (!it->ifa_addr || it->ifa_addr->sa_family != AF_INET) continue;
+    if (reinterpret_cast<sockaddr_in*>(it->ifa_addr)->sin_addr.s_addr == addr) {
+      result = it->ifa_name;
+      break;
+    }
+  }
+  ::freeifaddrs(ifs);
+  return result;
+}
+
+}  // namespace
+
+bool Receiver::open_packet_ring(const std::string& local_addr, uint16_t local_port) {
+  ring_dst_port_ = local_port;
+  ring_dst_addr_ = htonl(INADDR_ANY);
+  if (!local_addr.empty() && local_addr != "0.0.0.0" && local_addr != "*") {
+    ::inet_pton(AF_INET, local_addr.c_str(), &ring_dst_addr_);
+  }
+
+  // Drop-all filter on the port-reserving UDP socket (see file comment).
+  sock_filter drop_all[] = {{BPF_RET | BPF_K, 0, 0, 0}};
+  sock_fprog drop_prog{1, drop_all};
+  ::setsockopt(sock_fd_, SOL_SOCKET, SO_ATTACH_FILTER, &drop_prog, sizeof(drop_prog));
+
+  // SOCK_DGRAM: the link-layer header is stripped, so both the filter and tp_net see
+  // the packet from its IPv4 header on any link type.
+  ring_fd_ = ::socket(AF_PACKET, SOCK_DGRAM, htons(ETH_P_IP));
+  if (ring_fd_ < 0) {
+    std::cerr << "rtp::Receiver: socket(AF_PACKET) failed: " << std::strerror(errno)
+              << " (packet ring needs CAP_NET_RAW)" << std::endl;
+    return false;
+  }
+
+  // udp and dst port <port> and not a fragment (offsets relative to the IPv4 header).
+  sock_filter code[] = {
+      {BPF_LD | BPF_B | BPF_ABS, 0, 0, 9},                        // A = ip->protocol
+      {BPF_JMP | BPF_JEQ | BPF_K, 0, 6, IPPROTO_UDP},             //   != UDP -> drop
+      {BPF_LD | BPF_H | BPF_ABS, 0, 0, 6},                        // A = frag_off
+      {BPF_JMP | BPF_JSET | BPF_K, 4, 0, 0x3FFF},                 //   MF or offset -> drop
+      {BPF_LDX | BPF_B | BPF_MSH, 0, 0, 0},                       // X = ihl * 4
+      {BPF_LD | BPF_H | BPF_IND, 0, 0, 2},                        // A = udp->dest
+      {BPF_JMP | BPF_JEQ | BPF_K, 0, 1, local_port},              //   != port -> drop
+      {BPF_RET | BPF_K, 0, 0, static_cast<uint32_t>(0x40000)},    // accept (whole packet)
+      {BPF_RET | BPF_K, 0, 0, 0},                                 // drop
+  };
+  sock_fprog prog{static_cast<unsigned short>(sizeof(code) / sizeof(code[0])), code};
+  if (::setsockopt(ring_fd_, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) < 0) {
+    std::cerr << "rtp::Receiver: SO_ATTACH_FILTER failed: " << std::strerror(errno) << std::endl;
+    close_packet_ring();
+    return false;
+  }
+
+  int version = TPACKET_V3;
+  if (::setsockopt(ring_fd_, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+    std::cerr << "rtp::Receiver: PACKET_VERSION(TPACKET_V3) failed: " << std::strerror(errno) << std::endl;
+    close_packet_ring();
+    return false;
+  }
+
+  // V3 packs variable-size frames into each block; tp_frame_size only has to divide the
+  // block size and bound a single frame.
+  tpacket_req3 req{};
+  req.tp_block_size       = static_cast<unsigned>(ring_block_bytes_);
+  req.tp_block_nr         = static_cast<unsigned>(ring_block_count_);
+  req.tp_frame_size       = 2048;
+  req.tp_frame_nr         = static_cast<unsigned>(ring_block_bytes_ / req.tp_frame_size * ring_block_count_);
+  req.tp_retire_blk_tov   = ring_retire_ms_;
+  req.tp_sizeof_priv      = 0;
+  req.tp_feature_req_word = 0;
+  if (::setsockopt(ring_fd_, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+    std::cerr << "rtp::Receiver: PACKET_RX_RING(" << ring_block_count_ << " x " << ring_block_bytes_
+              << ") failed: " << std::strerror(errno) << std::endl;
+    close_packet_ring();
+    return false;
+  }
+
+  void* map = ::mmap(nullptr, ring_block_bytes_ * ring_block_count_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_LOCKED, ring_fd_, 0);
+  if (map == MAP_FAILED) {
+    // MAP_LOCKED fails under a low RLIMIT_MEMLOCK; the ring works unlocked, just with
+    // the usual page-fault exposure.
+    map = ::mmap(nullptr, ring_block_bytes_ * ring_block_count_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                 ring_fd_, 0);
+  }
+  if (map == MAP_FAILED) {
+    std::cerr << "rtp::Receiver: mmap(packet ring) failed: " << std::strerror(errno) << std::endl;
+    close_packet_ring();
+    return false;
+  }
+  ring_map_ = static_cast<uint8_t*>(map);
+
+  const std::string iface = ring_iface_.empty() ? iface_for_addr(ring_dst_addr_) : ring_iface_;
+  sockaddr_ll ll{};
+  ll.sll_family   = AF_PACKET;
+  ll.sll_protocol = htons(ETH_P_IP);
+  ll.sll_ifindex  = iface.empty() ? 0 : static_cast<int>(::if_nametoindex(iface.c_str()));
+  if (!iface.empty() && ll.sll_ifindex == 0) {
+    std::cerr << "rtp::Receiver: unknown interface " << iface << std::endl;
+    close_packet_ring();
+    return false;
+  }
+  if (::bind(ring_fd_, reinterpret_cast<sockaddr*>(&ll), sizeof(ll)) < 0) {
+    std::cerr << "rtp::Receiver: bind(AF_PACKET, " << (iface.empty() ? "any" : iface)
+              << ") failed: " << std::strerror(errno) << std::endl;
+    close_packet_ring();
+    return false;
+  }
+  return true;
+}
+
+void Receiver::close_packet_ring() {
+  if (ring_map_) {
+    ::munmap(ring_map_, ring_block_bytes_ * ring_block_count_);
+    ring_map_ = nullptr;
+  }
+  if (ring_fd_ >= 0) {
+    ::close(ring_fd_);
+    ring_fd_ = -1;
+  }
+}
+
+void Receiver::recv_loop_packet_ring() {
+  // Packet bytes stay in the kernel's block until it is handed back, so each accepted
+  // datagram is copied once into a staged slab. A rejected datagram (late, duplicate,
+  // alias) leaves the slab staged for the next one.
+  size_t staged = kNoSlab;
+  size_t block  = 0;
+  pollfd pfd{ring_fd_, POLLIN | POLLERR, 0};
+
+  while (running_.load(std::memory_order_acquire)) {
+    auto* bd = reinterpret_cast<tpacket_block_desc*>(ring_map_ + block * ring_block_bytes_);
+    if ((__atomic_load_n(&bd->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) {
+      // 100 ms poll timeout so stop() is noticed on an idle link.
+      ::poll(&pfd, 1, 100);
+      continue;
+    }
+
+    const uint32_t num_pkts = bd->hdr.bh1.num_pkts;
+    auto* ph = reinterpret_cast<tpacket3_hdr*>(reinterpret_cast<uint8_t*>(bd) + bd->hdr.bh1.offset_to_first_pkt);
+    for (uint32_t k = 0; k < num_pkts; ++k) {
+      const auto* ll = reinterpret_cast<const sockaddr_ll*>(reinterpret_cast<const uint8_t*>(ph)
+                                                            + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+      uint8_t* ip         = reinterpret_cast<uint8_t*>(ph) + ph->tp_net;
+      const size_t caplen = ph->tp_snaplen;
+      ph                  = reinterpret_cast<tpacket3_hdr*>(reinterpret_cast<uint8_t*>(ph) + ph->tp_next_offset);
+
+      if (ll->sll_pkttype == PACKET_OUTGOING) continue;  // loopback's transmit-side copy
+      if (caplen < 20 || (ip[0] >> 4) != 4) continue;
+      const size_t ihl = 4u * (ip[0] & 0x0F);
+      if (ihl < 20 || caplen < ihl + 8) continue;
+      uint32_t daddr;
+      std::memcpy(&daddr, ip + 16, sizeof(daddr));
+      if (ring_dst_addr_ != htonl(INADDR_ANY) && daddr != ring_dst_addr_) continue;
+      uint8_t* udp         = ip + ihl;
+      const size_t udp_len = static_cast<size_t>((udp[4] << 8) | udp[5]);
+      if (udp_len < 8 + 12 || ihl + udp_len > caplen) continue;
+      const size_t n = udp_len - 8;
+      if (n > max_datagram_) continue;
+
+      recv_datagrams_.fetch_add(1, std::memory_order_relaxed);
+      if (n > kSlabBytes) {  // jumbo: the copy goes straight into a run of slabs
+        const size_t run = acquire_slab(slabs_for(n));
+        if (run == kNoSlab) {
+          handle_dgram(udp + 8, n, kNoSlab);
+          continue;
+        }
+        std::memcpy(slab_ptr(run), udp + 8, n);
+        if (!handle_dgram(slab_ptr(run), n, run)) free_slab(run);
+        continue;
+      }
+      if (staged == kNoSlab) staged = acquire_slab();
+      if (staged == kNoSlab) {
+        handle_dgram(udp + 8, n, kNoSlab);  // sequence accounting only; counted busy
+        continue;
+      }
+      std::memcpy(slab_ptr(staged), udp + 8, n);
+      if (handle_dgram(slab_ptr(staged), n, staged)) staged = kNoSlab;
+    }
+    // One "call" per block: the stats line's batch= then reads as packets per block.
+    recv_calls_.fetch_add(1, std::memory_order_relaxed);
+    __atomic_store_n(&bd->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    block = (block + 1) % ring_block_count_;
+  }
+  if (staged != kNoSlab) free_slab(staged);
+}
+
+}  // namespace rtp
@@ -1,116 +1,407 @@
 #include "rtp_receiver.hpp"
 
 #include <arpa/inet.h>
+#include <linux/futex.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <pthread.h>
 #include <sched.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <chrono>
+#include <cmath>
 #include <cstring>
 #include <iostream>
+#include <vector>
+
+#include "rtp_wire.hpp"
 
 namespace rtp {
 
 namespace {
-constexpr uint8_t kRtpVersion = 2;
+// Header length (CSRCs and extension included) and trailing padding of an RTP packet.
+// False if it is not RTP version 2 or its lengths do not fit in `len`.
+bool parse_rtp(const uint8_t* data, size_t len, size_t& hdr, size_t& pad_len) {
+  const uint8_t b0 = data[0];
+  if ((b0 >> 6) != kRtpVersion) return false;
+  hdr = 12 + 4u * (b0 & 0x0F);
+  if (len < hdr) return false;
+  if (b0 & 0x10) {
+    if (len < hdr + 4) return false;
+    hdr += 4u + 4u * rd_u16(data + hdr + 2);
+    if (len < hdr) return false;
+  }
+  pad_len = (b0 & 0x20) ? data[len - 1] : 0;
+  return pad_len <= len - hdr;
+}
 
-inline uint16_t rd_u16(const uint8_t* p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
-inline uint32_t rd_u32(const uint8_t* p) {
-  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
-         | (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+// Spin-wait hint: lets an SMT sibling run and saves power while polling.
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+inline long futex(std::atomic<uint32_t>* addr, int op, uint32_t val, const timespec* timeout) {
+  return ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), op, val, timeout, nullptr, 0);
 }
 }  // namespace
 
-Receiver::Receiver() {
-  ring_ = std::unique_ptr<Slot[]>(new Slot[kRingSize]);
-  slab_.assign(kRingSize * kSlotBytes, 0);
-  job_queue_.assign(kJobQueueSize, Job{});
+// Pin to a CPU if requested. Best-effort: if the system doesn't have the requested CPU
+// or affinity isn't supported, log to stderr and continue.
+void Receiver::pin_thread(std::thread& t, int cpu, const char* name) {
+  if (cpu < 0) return;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  int rc = ::pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+  if (rc != 0) {
+    std::cerr << "rtp::Receiver: pthread_setaffinity_np(" << name << ", cpu=" << cpu
+              << ") failed: " << std::strerror(rc) << std::endl;
+  }
+#else
+  (void)t;
+  std::cerr << "rtp::Receiver: thread affinity not supported on this platform; ignoring " << name
+            << "_cpu=" << cpu << std::endl;
+#endif
 }
 
-Receiver::~Receiver() { stop(); }
+Receiver::Receiver() = default;
 
-bool Receiver::start(const std::string& local_addr, uint16_t local_port, void* hook_arg, Hook hook) {
-  if (running_.load()) return false;
+Receiver::~Receiver() {
+  stop();
+  unmap_slabs();
+}
+
+namespace {
+// Datagrams per second of a Capacity's stream (0 without a bitrate).
+double packet_rate(const Receiver::Capacity& c) {
+  return c.bitrate_mbps * 1e6 / 8.0 / static_cast<double>(std::max<size_t>(c.packet_bytes, 12));
+}
+}  // namespace
+
+size_t Receiver::slab_count() const {
+  const Capacity& c = capacity_;
+  size_t n          = c.slabs;
+  if (n == 0 && c.bitrate_mbps > 0) {
+    n = static_cast<size_t>(std::ceil(packet_rate(c) * c.hold_ms / 1000.0)) * slabs_for(c.packet_bytes);
+  }
+  if (n == 0) n = kDefaultSlabs;
+  return std::max(n, kMinSlabs);
+}
+
+size_t Receiver::held_slab_cap() const {
+  // frame_handler holds one index per packet; a jumbo packet's run counts once.
+  const Capacity& c      = capacity_;
+  const size_t per_pkt   = slabs_for(c.packet_bytes);
+  const size_t pool_pkts = slab_count() / per_pkt;
+  size_t cap             = pool_pkts * 3 / 16;
+  if (c.bitrate_mbps > 0 && c.frame_rate > 0) {
+    cap = static_cast<size_t>(std::ceil(2.5 * packet_rate(c) / c.frame_rate));
+  }
+  return std::clamp(cap, std::min<size_t>(64, pool_pkts / 2), pool_pkts / 2);
+}
+
+// Sizes the jitter ring, slab pool and job queue from capacity_. Buffers are reallocated
+// only when their size (or the pool's backing) changes, so restarting with the same
+// configuration keeps the memory. False if the pool cannot be mapped.
+bool Receiver::allocate_pool() {
+  const size_t slabs = slab_count();
+  size_t pow2        = 1;
+  while (pow2 < slabs) pow2 <<= 1;
+  max_datagram_ = std::clamp<size_t>(capacity_.max_datagram, 12, 65507);  // UDP payload limit
+  max_run_      = slabs_for(max_datagram_);
+  spill_bytes_  = max_datagram_ > kSlabBytes ? max_datagram_ - kSlabBytes : 0;
+
+  // A window wider than the 16-bit sequence space is never used.
+  const size_t ring = std::min<size_t>(pow2, 65536);
+  if (ring != ring_size_) {
+    ring_      = std::unique_ptr<Slot[]>(new Slot[ring]);
+    ring_size_ = ring;
+  }
+  if (slabs != slab_count_ || !slab_ || slab_pages_ != slab_map_asked_ || slab_lock_ != slab_map_locked_) {
+    slab_count_ = 0;
+    if (!map_slabs(slabs * kSlabBytes)) return false;
+    slab_gen_   = GenArray(new (std::align_val_t{64}) std::atomic<uint64_t>[slabs]);
+    slab_freed_ = GenArray(new (std::align_val_t{64}) std::atomic<uint64_t>[slabs]);
+    slab_run_   = std::unique_ptr<uint8_t[]>(new uint8_t[slabs]);
+    slab_count_ = slabs;
+  }
+  // One job per parked slab at most, so a queue the size of the pool never fills.
+  if (pow2 != job_queue_size_) {
+    job_queue_.assign(pow2, Job{});
+    job_queue_size_ = pow2;
+  }
+  return true;
+}
 
-  sock_fd_ = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-  if (sock_fd_ < 0) {
+// Creates, configures and binds one UDP receive socket. -1 on failure (logged).
+int Receiver::open_udp_socket(const sockaddr_in& addr, bool reuseport) {
+  int fd = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (fd < 0) {
     std::cerr << "rtp::Receiver: socket() failed: " << std::strerror(errno) << std::endl;
-    return false;
+    return -1;
   }
 
   int reuse = 1;
-  ::setsockopt(sock_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  if (reuseport) ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse));
   if (rcvbuf_size_ > 0) {
     // SO_RCVBUF is silently capped by net.core.rmem_max (208 KB on stock PetaLinux =
     // ~1.9 ms at 885 Mbps); SO_RCVBUFFORCE bypasses the cap when running as root.
-    if (::setsockopt(sock_fd_, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf_size_, sizeof(rcvbuf_size_)) < 0) {
-      ::setsockopt(sock_fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf_size_, sizeof(rcvbuf_size_));
+    if (::setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf_size_, sizeof(rcvbuf_size_)) < 0) {
+      ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf_size_, sizeof(rcvbuf_size_));
     }
   }
-
-  sockaddr_in addr{};
-  addr.sin_family = AF_INET;
-  addr.sin_port   = htons(local_port);
-  if (local_addr.empty() || local_addr == "0.0.0.0" || local_addr == "*") {
-    addr.sin_addr.s_addr = INADDR_ANY;
-  } else if (::inet_pton(AF_INET, local_addr.c_str(), &addr.sin_addr) != 1) {
-    std::cerr << "rtp::Receiver: inet_pton(" << local_addr << ") failed" << std::endl;
-    ::close(sock_fd_);
-    sock_fd_ = -1;
-    return false;
+  if (recv_batch_ > 1 && recv_batch_timeout_us_ > 0) {
+    // recvmmsg's own timeout is only checked after each datagram arrives, so on its own
+    // it can block indefinitely waiting to fill a batch at a stream tail. SO_RCVTIMEO
+    // bounds every individual wait; recvmmsg then returns the partial batch.
+    timeval tv{};
+    tv.tv_sec  = recv_batch_timeout_us_ / 1000000;
+    tv.tv_usec = recv_batch_timeout_us_ % 1000000;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  }
+  if (busy_poll_usec_ > 0) {
+    if (::setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_usec_, sizeof(busy_poll_usec_)) < 0) {
+      std::cerr << "rtp::Receiver: SO_BUSY_POLL(" << busy_poll_usec_ << ") failed: " << std::strerror(errno)
+                << std::endl;
+    }
+#if defined(SO_PREFER_BUSY_POLL)
+    int prefer = 1;
+    if (busy_poll_prefer_ && ::setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer)) < 0) {
+      std::cerr << "rtp::Receiver: SO_PREFER_BUSY_POLL failed: " << std::strerror(errno) << std::endl;
+    }
+    if (busy_poll_budget_ > 0
+        && ::setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &busy_poll_budget_, sizeof(busy_poll_budget_)) < 0) {
+      std::cerr << "rtp::Receiver: SO_BUSY_POLL_BUDGET(" << busy_poll_budget_
+                << ") failed: " << std::strerror(errno) << std::endl;
+    }
+#endif
   }
 
-  if (::bind(sock_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+  if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
     std::cerr << "rtp::Receiver: bind() failed: " << std::strerror(errno) << std::endl;
-    ::close(sock_fd_);
-    sock_fd_ = -1;
-    return false;
+    ::close(fd);
+    return -1;
   }
+  return fd;
+}
 
+bool Receiver::start(const std::string& local_addr, uint16_t local_port, void* hook_arg, Hook hook) {
+  if (running_.load()) return false;
   hook_     = std::move(hook);
   hook_arg_ = hook_arg;
-  started_  = false;
-  next_seq_ = 0;
-  pending_  = 0;
-  for (size_t i = 0; i < kRingSize; ++i) {
+  return start(local_addr, local_port, hook_handler_);
+}
+
+bool Receiver::start_worker(const std::string& local_addr, uint16_t local_port, void* handler,
+                            WorkerEntry entry, DeliverEntry deliver) {
+  if (running_.load()) return false;
+
+  auto resolve = [](const std::string& host, uint16_t port, sockaddr_in& out) {
+    out            = sockaddr_in{};
+    out.sin_family = AF_INET;
+    out.sin_port   = htons(port);
+    if (host.empty() || host == "0.0.0.0" || host == "*") {
+      out.sin_addr.s_addr = INADDR_ANY;
+    } else if (::inet_pton(AF_INET, host.c_str(), &out.sin_addr) != 1) {
+      std::cerr << "rtp::Receiver: inet_pton(" << host << ") failed" << std::endl;
+      return false;
+    }
+    return true;
+  };
+  sockaddr_in addr;
+  if (!resolve(local_addr, local_port, addr)) return false;
+  const bool dual_path = !redundant_addr_.empty();
+  sockaddr_in path1;
+  if (dual_path) {
+    if (ingest_ != Ingest::kSocket || recv_sockets_ > 1) {
+      std::cerr << "rtp::Receiver: a redundant path needs socket ingest on a single socket" << std::endl;
+      return false;
+    }
+    if (!resolve(redundant_addr_, redundant_port_, path1)) return false;
+  }
+  if (fec_port_ && (ingest_ != Ingest::kSocket || recv_sockets_ > 1 || dual_path)) {
+    // The rebuild stages slabs from the recv thread's side of the pool.
+    std::cerr << "rtp::Receiver: FEC needs socket ingest on a single socket" << std::endl;
+    return false;
+  }
+  if (!nack_addr_.empty()
+      && ((recv_sockets_ > 1 && ingest_ == Ingest::kSocket) || dual_path || ingest_ == Ingest::kTcp)) {
+    // The lanes merge by the media stream's sequence numbers; retransmissions have their own.
+    std::cerr << "rtp::Receiver: retransmission needs a single UDP receive socket" << std::endl;
+    return false;
+  }
+  if (!srtp_key_.empty() && (fec_port_ || !nack_addr_.empty())) {
+    // Parity and RTX packets would need protecting streams of their own.
+    std::cerr << "rtp::Receiver: SRTP does not combine with FEC or retransmission" << std::endl;
+    return false;
+  }
+  if (!allocate_pool()) return false;
+
+  if (worker_wait_ == WorkerWait::kEventfd && worker_efd_ < 0) {
+    worker_efd_ = ::eventfd(0, EFD_CLOEXEC);
+    if (worker_efd_ < 0) {
+      std::cerr << "rtp::Receiver: eventfd() failed: " << std::strerror(errno) << std::endl;
+      return false;
+    }
+  }
+
+  // From here on every failure goes through fail(): it closes whatever is open so far
+  // (each close_* is a no-op for what never was), as stop() would.
+  auto fail = [this] {
+    if (sock_fd_ >= 0) {
+      ::close(sock_fd_);
+      sock_fd_ = -1;
+    }
+    close_packet_ring();
+    close_uring();
+    close_lanes();
+    close_fec();
+    close_nack();
+    close_srtp();
+    close_relay();
+    return false;
+  };
+  const bool multi_socket = (recv_sockets_ > 1 && ingest_ == Ingest::kSocket) || dual_path;
+  if (multi_socket) {
+    if (!open_lanes(addr, dual_path ? &path1 : nullptr)) return fail();
+  } else if (ingest_ == Ingest::kTcp) {
+    sock_fd_ = open_tcp_listener(addr);
+    if (sock_fd_ < 0) return fail();
+  } else {
+    sock_fd_ = open_udp_socket(addr, false);
+    if (sock_fd_ < 0) return fail();
+  }
+
+  gro_active_ = false;
+  if (udp_gro_ && ingest_ == Ingest::kSocket && !multi_socket) {
+    int on = 1;
+    if (::setsockopt(sock_fd_, IPPROTO_UDP, UDP_GRO, &on, sizeof(on)) == 0) {
+      gro_active_ = true;
+    } else {
+      std::cerr << "rtp::Receiver: UDP_GRO unsupported (" << std::strerror(errno)
+                << "); receiving one datagram per call" << std::endl;
+    }
+  }
+
+  if ((ingest_ == Ingest::kPacketRing && !open_packet_ring(local_addr, local_port))
+      || (ingest_ == Ingest::kIoUring && !open_uring())) {
+    return fail();
+  }
+
+  handler_         = handler;
+  deliver_         = deliver;
+  started_         = false;
+  next_seq_        = 0;
+  pending_         = 0;
+  delivered_any_   = false;
+  // The depth never exceeds half the ring, so a packet at the far edge of the window
+  // cannot alias the head's slot.
+  jitter_hi_         = std::min({jitter_max_, kJitterMaxDepth, ring_size_ / 2});
+  jitter_lo_         = std::min(jitter_min_, jitter_hi_);
+  jitter_adaptive_   = jitter_lo_ < jitter_hi_;
+  jitter_clock_      = 0;
+  jitter_window_max_ = 0;
+  jitter_t0_         = std::chrono::steady_clock::now();
+  jitter_depth_.store(jitter_hi_, std::memory_order_relaxed);
+  for (auto& h : reorder_hist_) h.store(0, std::memory_order_relaxed);
+  late_packets_.store(0, std::memory_order_relaxed);
+  resync_jump_     = static_cast<int>(std::min<size_t>(kResyncDepths * jitter_hi_, 16384));
+  resync_probe_    = false;
+  restart_pending_ = false;
+  admit_limit_     = static_cast<size_t>(admit_fraction_ * static_cast<double>(slab_count_));
+  admit_any_       = false;
+  admit_shed_      = false;
+  // Sized from jitter_hi_: the FEC history reaches back as far as the ring waits.
+  if (fec_port_ && !open_fec(addr)) return fail();
+  // A hole held for retransmission keeps the ring from advancing while packets keep
+  // coming, so the window reaches past the jitter depth, and a jump is only a restart
+  // beyond it. Bounded by the 16-bit sequence distance the ring compares in.
+  hold_limit_ = std::min<size_t>(ring_size_ / 2, 8192);
+  if (!nack_addr_.empty()) {
+    resync_jump_ = std::max(resync_jump_, static_cast<int>(2 * hold_limit_));
+    if (!open_nack()) return fail();
+  }
+  if (!srtp_key_.empty() && !open_srtp()) return fail();
+  if (!relay_dests_.empty() && !open_relay()) return fail();
+  for (size_t i = 0; i < ring_size_; ++i) {
     ring_[i].filled = false;
     ring_[i].len    = 0;
-    ring_[i].in_worker.store(0, std::memory_order_relaxed);
   }
+  for (size_t i = 0; i < slab_count_; ++i) {
+    slab_gen_[i].store(0, std::memory_order_relaxed);
+    slab_freed_[i].store(0, std::memory_order_relaxed);
+    slab_run_[i] = 1;
+  }
+  released_gen_.store(0, std::memory_order_relaxed);
+  next_gen_ = 1;
+  slab_cursor_ = 0;
+  stage_run_   = 1;
   job_head_.store(0, std::memory_order_relaxed);
   job_tail_.store(0, std::memory_order_relaxed);
+  job_tail_local_ = 0;
+  job_head_cache_ = 0;
   net_lost_packets_.store(0, std::memory_order_relaxed);
   slot_busy_drops_.store(0, std::memory_order_relaxed);
   queue_full_drops_.store(0, std::memory_order_relaxed);
+  relay_packets_.store(0, std::memory_order_relaxed);
+  relay_drops_.store(0, std::memory_order_relaxed);
+  relay_calls_.store(0, std::memory_order_relaxed);
+  resyncs_.store(0, std::memory_order_relaxed);
+  recv_calls_.store(0, std::memory_order_relaxed);
+  recv_datagrams_.store(0, std::memory_order_relaxed);
+  merge_drops_.store(0, std::memory_order_relaxed);
+  fec_packets_.store(0, std::memory_order_relaxed);
+  fec_recovered_.store(0, std::memory_order_relaxed);
+  fec_unrecoverable_.store(0, std::memory_order_relaxed);
+  nack_requested_.store(0, std::memory_order_relaxed);
+  rtx_recovered_.store(0, std::memory_order_relaxed);
+  rtx_late_.store(0, std::memory_order_relaxed);
+  nack_expired_.store(0, std::memory_order_relaxed);
+  srtp_auth_failures_.store(0, std::memory_order_relaxed);
+  srtp_replays_.store(0, std::memory_order_relaxed);
+  for (size_t i = 0; i < 2; ++i) {
+    path_packets_[i].store(0, std::memory_order_relaxed);
+    path_lost_[i].store(0, std::memory_order_relaxed);
+  }
+  path_skew_ns_.store(0, std::memory_order_relaxed);
+  path_skew_max_ns_.store(0, std::memory_order_relaxed);
+  worker_wakeups_.store(0, std::memory_order_relaxed);
+  worker_spins_.store(0, std::memory_order_relaxed);
+  worker_parked_.store(0, std::memory_order_relaxed);
+  worker_done_.store(0, std::memory_order_relaxed);
+  jobs_handed_    = 0;
+  rtc_inline_     = false;
+  rtc_in_frame_   = false;
+  rtc_frame_ns_   = 0;
+  rtc_retry_left_ = 0;
+  inline_frames_.store(0, std::memory_order_relaxed);
+  handoff_frames_.store(0, std::memory_order_relaxed);
+  rtc_fallbacks_.store(0, std::memory_order_relaxed);
+  shed_frames_.store(0, std::memory_order_relaxed);
+  shed_packets_.store(0, std::memory_order_relaxed);
 
   running_.store(true, std::memory_order_release);
-  worker_ = std::thread([this] { worker_loop(); });
-  thread_ = std::thread([this] { recv_loop(); });
-
-  // Pin to distinct CPUs if requested. Best-effort: if the system doesn't have the
-  // requested CPU or affinity isn't supported, log to stderr and continue.
-  auto pin = [](std::thread& t, int cpu, const char* name) {
-    if (cpu < 0) return;
-#if defined(__linux__)
-    cpu_set_t set;
-    CPU_ZERO(&set);
-    CPU_SET(cpu, &set);
-    int rc = ::pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
-    if (rc != 0) {
-      std::cerr << "rtp::Receiver: pthread_setaffinity_np(" << name << ", cpu=" << cpu
-                << ") failed: " << std::strerror(rc) << std::endl;
-    }
-#else
-    (void)t;
-    std::cerr << "rtp::Receiver: thread affinity not supported on this platform; ignoring " << name
-              << "_cpu=" << cpu << std::endl;
-#endif
-  };
-  pin(thread_, recv_cpu_, "recv");
-  pin(worker_, worker_cpu_, "worker");
+  if (slab_prefault_) prefault_ = std::thread([this] { prefault_slabs(); });
+  worker_ = std::thread([this, handler, entry] { entry(this, handler); });
+  // With several sockets or paths, thread_ is the merge stage and each lane has its own thread.
+  thread_ = std::thread([this] { lanes_ ? merge_loop() : recv_loop(); });
+  pin_thread(thread_, recv_cpu_, "recv");
+  pin_thread(worker_, worker_cpu_, "worker");
+  if (lanes_) start_lanes();
+  if (fec_) start_fec();
+  if (nack_) start_nack();
   return true;
 }
 
@@ -122,201 +413,713 @@ void Receiver::stop() {
     sock_fd_ = -1;
   }
   if (was_running) {
+    stop_lanes();  // lane threads feed the merge stage; stop them first
+    stop_fec();
+    stop_nack();
     if (thread_.joinable()) thread_.join();
     {
       std::lock_guard<std::mutex> lk(worker_mu_);
     }
     worker_cv_.notify_all();
+    std::atomic_thread_fence(std::memory_order_seq_cst);  // running_ store vs. worker_park's re-check
+    wake_worker();
     if (worker_.joinable()) worker_.join();
+    if (prefault_.joinable()) prefault_.join();
   }
+  if (worker_efd_ >= 0) {
+    ::close(worker_efd_);
+    worker_efd_ = -1;
+  }
+  // After the recv thread is gone: it walks the mapped rings.
+  close_packet_ring();
+  close_uring();
+  close_lanes();
+  close_fec();
+  close_nack();
+  close_srtp();
+  close_relay();
 }
 
 void Receiver::recv_loop() {
-  uint8_t buf[kSlotBytes];
+  if (ingest_ == Ingest::kPacketRing) {
+    recv_loop_packet_ring();
+    return;
+  }
+  if (ingest_ == Ingest::kIoUring) {
+    recv_loop_uring();
+    return;
+  }
+  if (ingest_ == Ingest::kTcp) {
+    recv_loop_tcp();
+    return;
+  }
+  if (gro_active_) {
+    recv_loop_gro();
+    return;
+  }
+  if (recv_batch_ > 1) {
+    recv_loop_batched();
+    return;
+  }
+  // The kernel writes straight into a staged slab; `scratch` only catches datagrams when
+  // every slab is held (they still go through handle_dgram for sequence accounting).
+  // Bytes past the staged run land in `spill` (see handle_received).
+  uint8_t scratch[kSlabBytes];
+  std::vector<uint8_t> spill(spill_bytes_);
+  iovec iov[2];
+  iov[1].iov_base = spill.data();
+  iov[1].iov_len  = spill.size();
+  size_t staged   = kNoSlab;
   while (running_.load(std::memory_order_acquire)) {
-    ssize_t n = ::recv(sock_fd_, buf, sizeof(buf), 0);
+    if (staged == kNoSlab) staged = acquire_slab(stage_run_);
+    uint8_t* buf    = (staged != kNoSlab) ? slab_ptr(staged) : scratch;
+    iov[0].iov_base = buf;
+    iov[0].iov_len  = slab_capacity(staged);
+    msghdr msg{};
+    msg.msg_iov    = iov;
+    msg.msg_iovlen = 2;
+    ssize_t n      = ::recvmsg(sock_fd_, &msg, 0);
     if (n < 0) {
-      if (errno == EINTR) continue;
+      if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) continue;
       break;
     }
+    recv_calls_.fetch_add(1, std::memory_order_relaxed);
+    recv_datagrams_.fetch_add(1, std::memory_order_relaxed);
     if (n < 12) continue;
-    handle_dgram(buf, static_cast<size_t>(n));
+    if (handle_received(buf, spill.data(), static_cast<size_t>(n), staged)) staged = kNoSlab;
+  }
+  if (staged != kNoSlab) free_slab(staged);
+}
+
+void Receiver::recv_loop_batched() {
+  const size_t batch = recv_batch_;
+  std::vector<uint8_t> scratch(batch * kSlabBytes);
+  std::vector<uint8_t> spill(batch * spill_bytes_);
+  std::vector<size_t> staged(batch, kNoSlab);
+  std::vector<iovec> iovs(2 * batch);  // [staged run or scratch, spill] per message
+  std::vector<mmsghdr> msgs(batch);
+  timespec timeout{};
+  timeout.tv_sec        = recv_batch_timeout_us_ / 1000000;
+  timeout.tv_nsec       = (recv_batch_timeout_us_ % 1000000) * 1000L;
+  const bool fill_batch = recv_batch_timeout_us_ > 0;
+  for (size_t i = 0; i < batch; ++i) {
+    iovs[2 * i + 1].iov_base = spill.data() + i * spill_bytes_;
+    iovs[2 * i + 1].iov_len  = spill_bytes_;
+  }
+
+  while (running_.load(std::memory_order_acquire)) {
+    // Slabs consumed by the previous batch are replaced; rejected ones stay staged. The
+    // kernel writes back msg_len and msg_hdr.msg_flags; re-arm every header per call.
+    for (size_t i = 0; i < batch; ++i) {
+      if (staged[i] == kNoSlab) staged[i] = acquire_slab(stage_run_);
+      iovs[2 * i].iov_base = (staged[i] != kNoSlab) ? slab_ptr(staged[i]) : scratch.data() + i * kSlabBytes;
+      iovs[2 * i].iov_len  = slab_capacity(staged[i]);
+
+      msgs[i].msg_hdr            = msghdr{};
+      msgs[i].msg_hdr.msg_iov    = &iovs[2 * i];
+      msgs[i].msg_hdr.msg_iovlen = 2;
+      msgs[i].msg_len            = 0;
+    }
+    int n = ::recvmmsg(sock_fd_, msgs.data(), static_cast<unsigned>(batch),
+                       fill_batch ? 0 : MSG_WAITFORONE, fill_batch ? &timeout : nullptr);
+    if (n < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) continue;
+      break;
+    }
+    recv_calls_.fetch_add(1, std::memory_order_relaxed);
+    recv_datagrams_.fetch_add(static_cast<size_t>(n), std::memory_order_relaxed);
+    for (int i = 0; i < n; ++i) {
+      if (msgs[i].msg_len < 12) continue;
+      if (handle_received(static_cast<uint8_t*>(iovs[2 * i].iov_base), spill.data() + i * spill_bytes_,
+                          msgs[i].msg_len, staged[i]))
+        staged[i] = kNoSlab;
+    }
   }
+  for (size_t s : staged)
+    if (s != kNoSlab) free_slab(s);
 }
 
-void Receiver::handle_dgram(uint8_t* data, size_t len) {
-  uint8_t b0 = data[0];
-  if ((b0 >> 6) != kRtpVersion) return;
-  uint8_t cc  = b0 & 0x0F;
-  uint8_t pad = (b0 >> 5) & 0x1;
-  uint8_t ext = (b0 >> 4) & 0x1;
+void Receiver::recv_loop_gro() {
+  // One recvmsg() returns either a plain datagram or a GRO super-datagram of segments
+  // of gso_size bytes (the last may be shorter). The receive buffer is an iovec array
+  // of `stride`-byte entries, each a staged slab: once stride == gso_size, segment k
+  // lands exactly in slab k. A segment that does not line up (first GRO read, a sender
+  // changing packet size, segments larger than kSlabBytes) is gathered into a fresh
+  // slab run — the only copying path.
+  constexpr size_t kGroMax    = 65536;
+  constexpr size_t kMinStride = 512;  // below this, per-segment slabs waste the pool
+  constexpr size_t kMaxIov    = kGroMax / kMinStride;
+  std::vector<uint8_t> scratch(kMaxIov * kSlabBytes);
+  std::vector<uint8_t> gather(max_datagram_);
+  std::vector<size_t> staged(kMaxIov, kNoSlab);
+  std::vector<iovec> iovs(kMaxIov);
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+  size_t stride = kSlabBytes;
+
+  while (running_.load(std::memory_order_acquire)) {
+    const size_t niov = std::min(kMaxIov, (kGroMax + stride - 1) / stride);
+    for (size_t i = 0; i < niov; ++i) {
+      if (staged[i] == kNoSlab) staged[i] = acquire_slab();
+      iovs[i].iov_base = (staged[i] != kNoSlab) ? slab_ptr(staged[i]) : scratch.data() + i * kSlabBytes;
+      iovs[i].iov_len  = stride;
+    }
+    msghdr msg{};
+    msg.msg_iov        = iovs.data();
+    msg.msg_iovlen     = niov;
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof(control);
+    const ssize_t rc   = ::recvmsg(sock_fd_, &msg, 0);
+    if (rc < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) continue;
+      break;
+    }
+    const size_t n = static_cast<size_t>(rc);
+    size_t gso     = 0;
+    for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c != nullptr; c = CMSG_NXTHDR(&msg, c)) {
+      if (c->cmsg_level == IPPROTO_UDP && c->cmsg_type == UDP_GRO) {
+        int v;
+        std::memcpy(&v, CMSG_DATA(c), sizeof(v));
+        gso = static_cast<size_t>(v);
+      }
+    }
+    const size_t seg = gso ? gso : n;  // no cmsg: a single, uncoalesced datagram
+
+    recv_calls_.fetch_add(1, std::memory_order_relaxed);
+    size_t k = 0;
+    for (size_t off = 0; seg && off < n; off += seg, ++k) {
+      const size_t len = std::min(seg, n - off);
+      recv_datagrams_.fetch_add(1, std::memory_order_relaxed);
+      if (len < 12 || len > max_datagram_) continue;
+      if (off == k * stride && len <= stride) {  // segment k sits exactly in iov k
+        if (handle_dgram(static_cast<uint8_t*>(iovs[k].iov_base), len, staged[k])) staged[k] = kNoSlab;
+        continue;
+      }
+      // Straddles iov entries: gather into a fresh slab (never one of the staged ones,
+      // which may still hold unprocessed segments).
+      const size_t slab = acquire_slab(slabs_for(len));
+      uint8_t* dst      = (slab != kNoSlab) ? slab_ptr(slab) : gather.data();
+      for (size_t b = 0; b < len;) {
+        const size_t src_off = off + b;
+        const size_t i       = src_off / stride;
+        const size_t in_iov  = src_off % stride;
+        const size_t chunk   = std::min(len - b, stride - in_iov);
+        std::memcpy(dst + b, static_cast<uint8_t*>(iovs[i].iov_base) + in_iov, chunk);
+        b += chunk;
+      }
+      if (!handle_dgram(dst, len, slab) && slab != kNoSlab) free_slab(slab);
+    }
+    // Adopt the sender's segment size as the stride so the next super-datagram scatters
+    // in place. Entries past the new iov count are returned to the pool.
+    if (gso >= kMinStride && gso <= kSlabBytes && gso != stride) {
+      stride = gso;
+      for (size_t i = std::min(kMaxIov, (kGroMax + stride - 1) / stride); i < kMaxIov; ++i) {
+        if (staged[i] != kNoSlab) free_slab(staged[i]);
+        staged[i] = kNoSlab;
+      }
+    }
+  }
+  for (size_t s : staged)
+    if (s != kNoSlab) free_slab(s);
+}
 
-  size_t hdr = 12 + 4u * cc;
-  if (len < hdr) return;
-  if (ext) {
-    if (len < hdr + 4) return;
-    uint16_t ext_words = rd_u16(data + hdr + 2);
-    hdr += 4u + 4u * ext_words;
-    if (len < hdr) return;
+// Stages a free run of `run` consecutive slabs from [base, base + count), scanning up to
+// kSlabProbe positions from `cursor`. Runs never wrap past the end of the range.
+size_t Receiver::acquire_in(size_t base, size_t count, size_t& cursor, size_t run) {
+  // Whole frames come back through released_gen_, so slab_freed_ (the worker's lines) is
+  // only read for slabs past the watermark.
+  const uint64_t released = released_gen_.load(std::memory_order_acquire);
+  auto is_free            = [&](size_t s) {
+    const uint64_t gen = slab_gen_[s].load(std::memory_order_acquire);
+    return gen <= released || slab_freed_[s].load(std::memory_order_acquire) == gen;
+  };
+  for (size_t probe = 0; probe < kSlabProbe; ++probe) {
+    if (cursor + run > count) cursor = 0;
+    const size_t i = base + cursor;
+    size_t k       = 0;
+    while (k < run && is_free(i + k)) ++k;
+    cursor = (cursor + k + 1 >= count) ? 0 : cursor + k + 1;  // past the run, or the held slab
+    if (k == run) {
+      for (k = 0; k < run; ++k) slab_gen_[i + k].store(kSlabStaged, std::memory_order_relaxed);
+      slab_run_[i] = static_cast<uint8_t>(run);
+      return i;
+    }
   }
+  return kNoSlab;
+}
+
+// Gives back the tail of a staged run that `len` bytes do not use. Called before the run
+// is parked, while this thread still owns it.
+void Receiver::trim_run(size_t slab, size_t len) {
+  const size_t need = slabs_for(len);
+  const size_t run  = slab_run_[slab];
+  if (need >= run) return;
+  slab_run_[slab] = static_cast<uint8_t>(need);
+  for (size_t k = need; k < run; ++k) slab_gen_[slab + k].store(0, std::memory_order_release);
+}
 
-  size_t pad_len = 0;
-  if (pad) {
-    pad_len = data[len - 1];
-    if (pad_len > len - hdr) return;
+// Copies a datagram whose first `cap` bytes are at `data` and the rest in `spill` into
+// the run starting at `run`.
+void Receiver::join_spill(size_t run, const uint8_t* data, size_t cap, const uint8_t* spill, size_t len) {
+  uint8_t* dst = slab_ptr(run);
+  std::memcpy(dst, data, cap);
+  std::memcpy(dst + cap, spill, len - cap);
+}
+
+// handle_dgram for a datagram scattered over [data: the staged run, spill]. One that
+// fits the run goes straight through (the run trimmed to its length). One that spilled
+// is joined into a fresh run of the right length and `slab` stays staged; the next
+// stage_run_ matches it, so a steady jumbo stream only copies on its first packet.
+// Same return contract as handle_dgram.
+bool Receiver::handle_received(uint8_t* data, const uint8_t* spill, size_t len, size_t slab) {
+  stage_run_       = std::min(slabs_for(len), max_run_);
+  const size_t cap = slab_capacity(slab);
+  if (len <= cap) {
+    if (slab != kNoSlab) trim_run(slab, len);
+    return handle_dgram(data, len, slab);
+  }
+  const size_t run = (slab != kNoSlab) ? acquire_slab(stage_run_) : kNoSlab;
+  if (run == kNoSlab) {
+    // Sequence accounting only (counted busy); the length is clamped to the bytes at
+    // `data` so the padding check stays in bounds. An SRTP packet cut short cannot be
+    // authenticated, so it is only counted.
+    if (srtp_) {
+      slot_busy_drops_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      handle_dgram(data, cap, kNoSlab);
+    }
+    return false;
   }
+  join_spill(run, data, cap, spill, len);
+  if (!handle_dgram(slab_ptr(run), len, run)) free_slab(run);
+  return false;
+}
+
+// `data` is the datagram as received into `slab` (kNoSlab: every slab was held, the bytes
+// are in scratch). Returns true iff the slab was parked in the ring — ownership moved on
+// and the caller must stage a fresh one; false leaves it staged for reuse.
+bool Receiver::handle_dgram(uint8_t* data, size_t len, size_t slab) {
+  if (fec_ && started_) fec_poll();  // may rebuild earlier packets into the ring first
+  if (srtp_ && !srtp_unprotect(data, len)) return false;
+  size_t hdr, pad_len;
+  if (!parse_rtp(data, len, hdr, pad_len)) return false;
   size_t effective_len = len - pad_len;
-  if (effective_len > kSlotBytes) return;
+  if (effective_len > max_datagram_) return false;
 
-  uint16_t seq = rd_u16(data + 2);
+  // A retransmission becomes the packet it carries; it is a hole being filled, not
+  // reordering, so it stays out of the reorder statistics.
+  bool rtx = false;
+  if (nack_) {
+    if ((data[1] & 0x7F) != rtx_pt_) {
+      media_pt_ = data[1] & 0x7F;
+    } else {
+      if (!started_ || !unwrap_rtx(data, len)) return false;
+      rtx           = true;
+      effective_len = len - pad_len;
+    }
+  }
+  uint16_t seq        = rd_u16(data + 2);
+  const uint32_t ssrc = rd_u32(data + 8);
 
   if (!started_) {
     started_  = true;
     next_seq_ = seq;
+    high_seq_ = seq;
+    ssrc_     = ssrc;
   }
 
   int16_t diff = static_cast<int16_t>(seq - next_seq_);
+  if (ssrc != ssrc_ || diff >= resync_jump_ || diff <= -resync_jump_) {
+    if (!resync(seq, ssrc, diff)) return false;
+    diff = 0;
+  }
+  // How far behind the newest sequence number this packet arrived.
+  const int16_t behind = static_cast<int16_t>(high_seq_ - seq);
   if (diff < 0) {
-    return;  // late or duplicate
+    // Duplicate of a delivered packet (its slot still names it) or late: the ring had
+    // already force-advanced past it.
+    if (rtx) {
+      rtx_late_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    if (behind > 0 && ring_[seq & (ring_size_ - 1)].seq != seq) {
+      late_packets_.fetch_add(1, std::memory_order_relaxed);
+      note_reorder(static_cast<size_t>(behind));
+    }
+    return false;
   }
+  if (behind < -1 && nack_ && !rtx) nack_gap(static_cast<uint16_t>(high_seq_ + 1), static_cast<size_t>(-behind - 1));
+  if (behind < 0) high_seq_ = seq;
+  if (jitter_adaptive_ && (++jitter_clock_ & kJitterClockMask) == 0) adapt_jitter();
 
   // If gap exceeds jitter depth, force-advance head past missing slots, dispatching any that did arrive.
-  while (diff >= static_cast<int16_t>(jitter_depth_)) {
-    size_t i   = next_seq_ & (kRingSize - 1);
-    Slot& head = ring_[i];
-    if (head.filled && head.seq == next_seq_) {
-      dispatch(i, head.len, head.seq, head.hdr_len);
-      head.filled = false;
-      head.len    = 0;
-      --pending_;
-    } else {
-      net_lost_packets_.fetch_add(1, std::memory_order_relaxed);
+  const int16_t depth = static_cast<int16_t>(jitter_depth_.load(std::memory_order_relaxed));
+  if (diff >= depth) {
+    while (diff >= depth) {
+      size_t i   = next_seq_ & (ring_size_ - 1);
+      Slot& head = ring_[i];
+      if (head.filled && head.seq == next_seq_) {
+        dispatch(head.slab, head.len, head.seq, head.hdr_len);
+        head.filled = false;
+        head.len    = 0;
+        --pending_;
+      } else {
+        // Hold for a requested retransmission while the window has room for it.
+        if (nack_ && nack_hold(next_seq_, diff < static_cast<int16_t>(hold_limit_))) break;
+        net_lost_packets_.fetch_add(1, std::memory_order_relaxed);
+      }
+      ++next_seq_;
+      diff = static_cast<int16_t>(seq - next_seq_);
     }
-    ++next_seq_;
-    diff = static_cast<int16_t>(seq - next_seq_);
+    publish_jobs();
   }
 
-  size_t idx = seq & (kRingSize - 1);
+  size_t idx = seq & (ring_size_ - 1);
   Slot& slot = ring_[idx];
   if (slot.filled) {
-    if (slot.seq == seq) return;  // duplicate, not a loss
+    if (slot.seq == seq) {  // duplicate, not a loss
+      if (rtx) rtx_late_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
     // Alias: ring slot already holds a different seq from a prior wrap-around.
     // The new packet was received but cannot be stored — count as net loss.
     net_lost_packets_.fetch_add(1, std::memory_order_relaxed);
-    return;
+    return false;
   }
-  // Worker may still own this slab slot from an earlier in-flight job.
-  if (slot.in_worker.load(std::memory_order_acquire) != 0) {
+  if (behind > 0 && !rtx) note_reorder(static_cast<size_t>(behind));
+  // No free slab was available to receive into: the worker holds (nearly) the whole pool.
+  if (slab == kNoSlab) {
     slot_busy_drops_.fetch_add(1, std::memory_order_relaxed);
-    return;
+    return false;
   }
-  std::memcpy(slab_.data() + idx * kSlotBytes, data, effective_len);
+  if (fec_) fec_store(seq, data, len);
   slot.seq     = seq;
   slot.hdr_len = static_cast<uint16_t>(hdr);
   slot.len     = effective_len;
+  slot.slab    = slab;
   slot.filled  = true;
   ++pending_;
+  if (rtx) rtx_recovered_.fetch_add(1, std::memory_order_relaxed);
 
   release_in_order();
+  if (nack_) nack_issue();
+  return true;
+}
+
+// handle_dgram for an ordered transport (kTcp): packets come in sequence, so there is
+// nothing to reorder and the jitter ring is skipped — each goes to dispatch() as it
+// arrives. A sequence gap is loss upstream of the stream (net lost, flagged on the next
+// packet as after a force-advance); a new SSRC, a step back or a jump of resync_jump_ is
+// a restart. kNoSlab: sequence accounting only, counted busy. Returns true iff the slab
+// went to dispatch(); the caller publishes the jobs.
+bool Receiver::handle_inorder(uint8_t* data, size_t len, size_t slab) {
+  if (srtp_ && !srtp_unprotect(data, len)) return false;
+  size_t hdr, pad_len;
+  if (!parse_rtp(data, len, hdr, pad_len)) return false;
+  const size_t effective_len = len - pad_len;
+  if (effective_len > max_datagram_) return false;
+  const uint16_t seq  = rd_u16(data + 2);
+  const uint32_t ssrc = rd_u32(data + 8);
+  if (!started_) {
+    started_  = true;
+    next_seq_ = seq;
+    ssrc_     = ssrc;
+  }
+  const int16_t diff = static_cast<int16_t>(seq - next_seq_);
+  if (ssrc != ssrc_ || diff < 0 || diff >= resync_jump_) {
+    if (ssrc == ssrc_ && diff > 0) net_lost_packets_.fetch_add(static_cast<size_t>(diff), std::memory_order_relaxed);
+    ssrc_            = ssrc;
+    delivered_any_   = false;
+    restart_pending_ = true;
+    resyncs_.fetch_add(1, std::memory_order_relaxed);
+  } else if (diff > 0) {
+    net_lost_packets_.fetch_add(static_cast<size_t>(diff), std::memory_order_relaxed);
+  }
+  next_seq_ = static_cast<uint16_t>(seq + 1);
+  high_seq_ = seq;
+  if (slab == kNoSlab) {
+    slot_busy_drops_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  dispatch(slab, effective_len, seq, static_cast<uint16_t>(hdr));
+  return true;
+}
+
+// Discontinuity: a new SSRC, or a sequence jump of resync_jump_ or more. Instead of
+// force-advancing through every sequence number in between (thousands of iterations,
+// each counted lost, stalling the recv thread mid-burst), deliver what the jitter ring
+// still holds of the old stream, re-seed next_seq_ at this packet and flag the restart
+// on the next delivered packet. A backward jump on the same SSRC could be one stray
+// old packet, so it takes effect only when the next packet continues from it; the
+// first is dropped. Returns false if this packet is to be dropped.
+bool Receiver::resync(uint16_t seq, uint32_t ssrc, int16_t diff) {
+  if (ssrc == ssrc_ && diff < 0 && !(resync_probe_ && seq == resync_probe_seq_)) {
+    resync_probe_     = true;
+    resync_probe_seq_ = static_cast<uint16_t>(seq + 1);
+    return false;
+  }
+  resync_probe_ = false;
+  // Pending slots all lie within jitter_depth_ of next_seq_, so this walk is short.
+  for (size_t n = 0; pending_ > 0 && n < ring_size_; ++n, ++next_seq_) {
+    Slot& s = ring_[next_seq_ & (ring_size_ - 1)];
+    if (!s.filled || s.seq != next_seq_) continue;
+    dispatch(s.slab, s.len, s.seq, s.hdr_len);
+    s.filled = false;
+    s.len    = 0;
+    --pending_;
+  }
+  publish_jobs();
+  // Same sender skipping ahead is loss as far as anyone can tell; count it in one step.
+  if (ssrc == ssrc_ && diff > 0) net_lost_packets_.fetch_add(static_cast<size_t>(diff), std::memory_order_relaxed);
+  if (nack_) nack_reset();
+  next_seq_        = seq;
+  high_seq_        = seq;
+  ssrc_            = ssrc;
+  delivered_any_   = false;  // the restart is not a gap in the new stream
+  restart_pending_ = true;
+  resyncs_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+// A packet that arrived `distance` sequence numbers behind the newest one: histogram it
+// and, with an adaptive depth, grow the depth at once when the margin got thin — the
+// interval check in adapt_jitter() only ever shrinks it.
+void Receiver::note_reorder(size_t distance) {
+  const size_t bucket = std::min<size_t>(63 - __builtin_clzll(distance), kReorderBuckets - 1);
+  reorder_hist_[bucket].fetch_add(1, std::memory_order_relaxed);
+  jitter_window_max_ = std::max(jitter_window_max_, distance);
+  if (jitter_adaptive_ && 2 * distance > jitter_depth_.load(std::memory_order_relaxed))
+    jitter_depth_.store(std::min(2 * distance, jitter_hi_), std::memory_order_relaxed);
+}
+
+// Once per kJitterIntervalMs: twice the interval's farthest reorder is all the depth the
+// network asked for. Shrinking is at most a halving per interval, so a burst of
+// reordering every few seconds does not see the depth collapse in between.
+void Receiver::adapt_jitter() {
+  const auto now = std::chrono::steady_clock::now();
+  if (now - jitter_t0_ < std::chrono::milliseconds(kJitterIntervalMs)) return;
+  jitter_t0_         = now;
+  const size_t depth = jitter_depth_.load(std::memory_order_relaxed);
+  const size_t need  = std::clamp(2 * jitter_window_max_, jitter_lo_, jitter_hi_);
+  if (need < depth) jitter_depth_.store(std::max(need, depth / 2), std::memory_order_relaxed);
+  jitter_window_max_ = 0;
 }
 
 void Receiver::release_in_order() {
+  // A packet that fills a gap releases every in-order slot queued behind it; the whole
+  // run goes to the worker with one tail store.
   while (pending_ > 0) {
-    size_t i = next_seq_ & (kRingSize - 1);
+    size_t i = next_seq_ & (ring_size_ - 1);
     Slot& s  = ring_[i];
     if (!s.filled || s.seq != next_seq_) break;
-    dispatch(i, s.len, s.seq, s.hdr_len);
+    dispatch(s.slab, s.len, s.seq, s.hdr_len);
     s.filled = false;
     s.len    = 0;
     --pending_;
     ++next_seq_;
   }
+  publish_jobs();
 }
 
 void Receiver::dispatch(size_t slab_idx, size_t len, uint16_t seq, uint16_t hdr_len) {
-  // Hand off slab ownership to the worker, then enqueue the job.
-  ring_[slab_idx].in_worker.store(1, std::memory_order_release);
-
-  // Notify only on empty→non-empty transition. Saves one futex wakeup per packet at
-  // steady state (worker is normally not in wait_for). The worker_loop's 1 ms wait_for
-  // timeout is the safety net if a notify is missed due to a race with worker entering
-  // wait between its empty-check and the actual sleep.
-  const size_t head_before = job_head_.load(std::memory_order_acquire);
-  const size_t tail_before = job_tail_.load(std::memory_order_relaxed);
-  const bool was_empty     = (head_before == tail_before);
-
-  if (!enqueue_job(Job{slab_idx, len, seq, hdr_len})) {
-    // Worker is far behind. Drop this packet, return slab ownership to recv.
-    ring_[slab_idx].in_worker.store(0, std::memory_order_release);
+  // Loss and frame-boundary flags against the last packet the hook got. A packet dropped
+  // below on a full queue is not delivered, so the next one carries the gap.
+  const uint32_t stamp = rd_u32(slab_ptr(slab_idx) + 4);
+  if (admit_limit_ && !admit(stamp)) {
+    // Shed with its frame: back to the pool before the worker ever sees it. The next
+    // admitted frame starts on a new timestamp, so the skip is not reported as a gap.
+    free_slab(slab_idx);
+    shed_packets_.fetch_add(1, std::memory_order_relaxed);
+    delivered_any_ = true;
+    last_seq_      = seq;
+    last_stamp_    = stamp;
+    return;
+  }
+  uint8_t flags = 0;
+  if (delivered_any_ && seq != static_cast<uint16_t>(last_seq_ + 1)) flags |= Packet::kGap;
+  if (!delivered_any_ || stamp != last_stamp_) flags |= Packet::kNewTimestamp;
+  if (restart_pending_) flags |= Packet::kRestart;
+  const Job j{slab_idx, len, seq, hdr_len, flags};
+  if (rtc_) {
+    // The marker bit ends a frame; the path is chosen when the next one starts.
+    const bool marker = (slab_ptr(slab_idx)[1] & 0x80) != 0;
+    if (!rtc_in_frame_) rtc_inline_ = rtc_begin_frame();
+    rtc_in_frame_ = !marker;
+    if (rtc_inline_) {
+      restart_pending_ = false;
+      delivered_any_   = true;
+      last_seq_        = seq;
+      last_stamp_      = stamp;
+      rtc_deliver(j, marker);
+      return;
+    }
+    if (marker) handoff_frames_.fetch_add(1, std::memory_order_relaxed);
+  }
+  // The slab is already owned (since it was staged); the job hands it to the worker
+  // once publish_jobs() runs, whose release store also publishes the generation.
+  if (!stage_job(j)) {
+    // Worker is far behind. Drop this packet, return the slab to the free pool.
+    free_slab(slab_idx);
     queue_full_drops_.fetch_add(1, std::memory_order_relaxed);
     return;
   }
-  if (was_empty) worker_cv_.notify_one();
+  ++jobs_handed_;
+  restart_pending_   = false;
+  delivered_any_     = true;
+  last_seq_          = seq;
+  last_stamp_        = stamp;
+  const uint64_t gen = next_gen_++;
+  for (size_t k = slab_run_[slab_idx]; k-- > 0;) slab_gen_[slab_idx + k].store(gen, std::memory_order_relaxed);
 }
 
-bool Receiver::enqueue_job(const Job& j) {
-  size_t tail      = job_tail_.load(std::memory_order_relaxed);
-  size_t next_tail = (tail + 1) & (kJobQueueSize - 1);
-  if (next_tail == job_head_.load(std::memory_order_acquire)) {
-    return false;  // full
+// Frame admission: decided once, at a frame's first in-order packet, against the jobs the
+// worker has not finished yet; every later packet of the frame follows that decision.
+bool Receiver::admit(uint32_t stamp) {
+  if (!admit_any_ || stamp != admit_stamp_) {
+    admit_any_   = true;
+    admit_stamp_ = stamp;
+    admit_shed_  = jobs_handed_ - worker_done_.load(std::memory_order_acquire) >= admit_limit_;
+    if (admit_shed_) shed_frames_.fetch_add(1, std::memory_order_relaxed);
   }
-  job_queue_[tail] = j;
-  job_tail_.store(next_tail, std::memory_order_release);
-  return true;
+  return !admit_shed_;
+}
+
+// Run-to-completion: the path for the frame starting now. After a fallback the worker
+// keeps kRtcRetryFrames frames; inline delivery resumes only once it has processed every
+// job handed to it (its release store of worker_done_ orders that work before ours).
+bool Receiver::rtc_begin_frame() {
+  if (rtc_inline_) return true;
+  if (rtc_retry_left_ > 0) {
+    --rtc_retry_left_;
+    return false;
+  }
+  return worker_done_.load(std::memory_order_acquire) == jobs_handed_;
 }
 
-bool Receiver::dequeue_job(Job& out) {
-  size_t head = job_head_.load(std::memory_order_relaxed);
-  if (head == job_tail_.load(std::memory_order_acquire)) {
-    return false;  // empty
+// Run-to-completion: hands one in-order packet to the handler on this thread and times
+// it against the frame's budget.
+void Receiver::rtc_deliver(const Job& j, bool marker) {
+  const uint64_t gen = next_gen_++;
+  for (size_t k = slab_run_[j.slab_idx]; k-- > 0;) slab_gen_[j.slab_idx + k].store(gen, std::memory_order_relaxed);
+  const auto t0 = std::chrono::steady_clock::now();
+  deliver_(this, handler_, &j, 1);
+  rtc_frame_ns_ += static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+  if (!marker) return;
+  inline_frames_.fetch_add(1, std::memory_order_relaxed);
+  if (rtc_frame_ns_ > uint64_t{rtc_budget_us_} * 1000) {
+    // Parsing held the recv thread too long: the next frames go to the worker.
+    rtc_inline_     = false;
+    rtc_retry_left_ = kRtcRetryFrames;
+    rtc_fallbacks_.fetch_add(1, std::memory_order_relaxed);
   }
-  out = job_queue_[head];
-  job_head_.store((head + 1) & (kJobQueueSize - 1), std::memory_order_release);
+  rtc_frame_ns_ = 0;
+}
+
+// Writes a job past the published tail; invisible to the worker until publish_jobs().
+bool Receiver::stage_job(const Job& j) {
+  const size_t next = (job_tail_local_ + 1) & (job_queue_size_ - 1);
+  if (next == job_head_cache_) {
+    // Looks full against the cached consumer index; only now read the shared one.
+    job_head_cache_ = job_head_.load(std::memory_order_acquire);
+    if (next == job_head_cache_) return false;  // full
+  }
+  job_queue_[job_tail_local_] = j;
+  job_tail_local_             = next;
   return true;
 }
 
-void Receiver::worker_loop() {
-  while (running_.load(std::memory_order_acquire)) {
-    Job j;
-    if (dequeue_job(j)) {
-      process_job(j);
-      continue;
-    }
+void Receiver::publish_jobs() {
+  const size_t tail_before = job_tail_.load(std::memory_order_relaxed);
+  if (job_tail_local_ == tail_before) return;
+  // kCondvar: notify only on empty→non-empty transition. Saves one futex wakeup per
+  // run at steady state (worker is normally not in wait_for). The worker_loop's 1 ms
+  // wait_for timeout is the safety net if a notify is missed due to a race with worker
+  // entering wait between its empty-check and the actual sleep.
+  const bool was_empty = job_head_.load(std::memory_order_acquire) == tail_before;
+  job_tail_.store(job_tail_local_, std::memory_order_release);
+  switch (worker_wait_) {
+    case WorkerWait::kCondvar:
+      if (was_empty) worker_cv_.notify_one();
+      break;
+    case WorkerWait::kSpin:
+      break;
+    case WorkerWait::kSpinPark:
+    case WorkerWait::kEventfd:
+      // Pairs with the fence in worker_park(): either the worker sees this job on its
+      // re-check, or we see its parked flag. No missed wakeup, so no timeout needed.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (worker_parked_.load(std::memory_order_relaxed)) wake_worker();
+      break;
+  }
+}
+
+// Copies out up to `max` jobs with one acquire of job_tail_ and one release of job_head_.
+size_t Receiver::dequeue_jobs(Job* out, size_t max) {
+  const size_t head = job_head_.load(std::memory_order_relaxed);
+  const size_t tail = job_tail_.load(std::memory_order_acquire);
+  const size_t n    = std::min((tail - head) & (job_queue_size_ - 1), max);
+  for (size_t k = 0; k < n; ++k) out[k] = job_queue_[(head + k) & (job_queue_size_ - 1)];
+  if (n) job_head_.store((head + n) & (job_queue_size_ - 1), std::memory_order_release);
+  return n;
+}
+
+// One empty-queue poll of the worker loop: sleep, spin or park per worker_wait_.
+void Receiver::worker_idle(size_t& spins) {
+  if (worker_wait_ == WorkerWait::kCondvar) {
     std::unique_lock<std::mutex> lk(worker_mu_);
     worker_cv_.wait_for(lk, std::chrono::milliseconds(1), [this] {
       return !running_.load(std::memory_order_acquire)
-             || job_head_.load(std::memory_order_acquire)
-                    != job_tail_.load(std::memory_order_acquire);
+             || job_head_.load(std::memory_order_acquire) != job_tail_.load(std::memory_order_acquire);
     });
+    worker_wakeups_.fetch_add(1, std::memory_order_relaxed);
+  } else if (worker_wait_ == WorkerWait::kSpin || spins < worker_spin_) {
+    cpu_relax();
+    if (++spins == 65536) {  // keep the counter moving on a long idle spin
+      worker_spins_.fetch_add(spins, std::memory_order_relaxed);
+      spins = 0;
+    }
+  } else {
+    worker_spins_.fetch_add(spins, std::memory_order_relaxed);
+    spins = 0;
+    worker_park();
+  }
+}
+
+void Receiver::worker_park() {
+  worker_parked_.store(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  // Re-check after publishing the flag: a job enqueued before the store did not see it.
+  if (job_head_.load(std::memory_order_relaxed) != job_tail_.load(std::memory_order_acquire)
+      || !running_.load(std::memory_order_acquire)) {
+    worker_parked_.store(0, std::memory_order_relaxed);
+    return;
   }
-  // Drain remaining jobs so in-flight slot ownership flags don't leak.
-  Job j;
-  while (dequeue_job(j)) {
-    process_job(j);
-  }
-}
-
-void Receiver::process_job(const Job& j) {
-  // hdr_len was parsed once in handle_dgram and carried through Slot+Job; no re-parse.
-  // in_worker is NOT cleared here — the hook (frame_handler) owns the slab via
-  // Frame::slab_idx and must call release_slab() when done. This is what enables the
-  // chain reader to hold slabs across an entire frame's worth of packets without copy.
-  const uint8_t* data = slab_.data() + j.slab_idx * kSlotBytes;
-  if (j.hdr_len <= j.len && hook_) {
-    const uint8_t b1 = data[1];
-    Frame f{};
-    f.seq          = j.seq;
-    f.timestamp    = rd_u32(data + 4);
-    f.ssrc         = rd_u32(data + 8);
-    f.marker       = (b1 >> 7) & 0x1;
-    f.payload_type = b1 & 0x7F;
-    f.payload      = const_cast<uint8_t*>(data + j.hdr_len);
-    f.payload_len  = j.len - j.hdr_len;
-    f.slab_idx     = j.slab_idx;
-    hook_(hook_arg_, f);
+  if (worker_wait_ == WorkerWait::kEventfd) {
+    uint64_t count;
+    if (::read(worker_efd_, &count, sizeof(count)) < 0 && errno != EINTR) {
+      std::cerr << "rtp::Receiver: eventfd read failed: " << std::strerror(errno) << std::endl;
+    }
+  } else {
+    // Returns at once if wake_worker() already cleared the flag. The timeout is only a
+    // backstop for stop().
+    const timespec timeout{0, 100 * 1000 * 1000};
+    futex(&worker_parked_, FUTEX_WAIT_PRIVATE, 1, &timeout);
+  }
+  worker_parked_.store(0, std::memory_order_relaxed);
+  worker_wakeups_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Wakes a parked worker (kSpinPark / kEventfd). Clearing the flag first means a burst of
+// jobs costs one wake syscall, not one per job.
+void Receiver::wake_worker() {
+  if (worker_parked_.exchange(0, std::memory_order_acq_rel) == 0) return;
+  if (worker_wait_ == WorkerWait::kEventfd) {
+    const uint64_t one = 1;
+    if (::write(worker_efd_, &one, sizeof(one)) < 0) {
+      std::cerr << "rtp::Receiver: eventfd write failed: " << std::strerror(errno) << std::endl;
+    }
   } else {
-    // Hook not invoked — release the slab immediately so recv can recycle it.
-    ring_[j.slab_idx].in_worker.store(0, std::memory_order_release);
+    futex(&worker_parked_, FUTEX_WAKE_PRIVATE, 1, nullptr);
   }
 }
 
@@ -1,17 +1,26 @@
 #ifndef RTP_RECEIVER_HPP
 #define RTP_RECEIVER_HPP
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
+#include "rtp_srtp.hpp"
+
+struct sockaddr_in;
+
 namespace rtp {
 
 struct Frame {
@@ -22,75 +31,517 @@ struct Frame {
   uint8_t payload_type;
   uint8_t* payload;
   size_t payload_len;
-  // Slab slot this packet's bytes live in. The hook implementation may keep the slab
-  // alive past the hook return by calling Receiver::release_slab(slab_idx) later — the
-  // worker thread does NOT clear in_worker on its own. This is what enables zero-copy
-  // chain parsing (frame_handler holds slabs across an entire frame).
+  // Slab this packet's bytes live in (a slab pool index, NOT seq % ring size — the
+  // kernel writes each datagram straight into a staged free slab). The hook
+  // implementation may keep the slab alive past the hook return by calling
+  // Receiver::release_slab(slab_idx) later — the worker thread does NOT free it on its
+  // own. This is what enables zero-copy chain parsing (frame_handler holds slabs across
+  // an entire frame).
   size_t slab_idx;
+  // One or more packets before this one never reached the hook: lost on the network,
+  // force-advanced past by the jitter ring, or dropped on a full job queue. Never set on
+  // the first packet.
+  bool gap;
+  // RTP timestamp differs from the previous delivered packet's (set on the first one):
+  // a new frame has started, whether or not the last one's marker packet arrived.
+  bool new_timestamp;
+  // First packet after the receiver re-synced to a restarted sender (new SSRC, or a
+  // sequence jump far past the jitter window): the stream before it is over.
+  bool restart;
+};
+
+class Receiver;
+
+// One delivered packet as a statically dispatched handler sees it (Receiver::start with a
+// Handler). Nothing is copied out of the slab up front: each accessor reads its RTP
+// header field when called, so once the handler is inlined into the worker's job loop
+// the compiler schedules those loads together with the handler's own parse of the
+// payload header right behind them, and fields the handler never asks for cost nothing.
+// Same meaning and ownership rules as the Frame fields; frame() builds one.
+class Packet {
+ public:
+  uint16_t seq() const { return seq_; }
+  uint32_t timestamp() const { return be32(data_ + 4); }
+  uint32_t ssrc() const { return be32(data_ + 8); }
+  uint8_t marker() const { return static_cast<uint8_t>(data_[1] >> 7); }
+  uint8_t payload_type() const { return data_[1] & 0x7F; }
+  uint8_t* payload() const { return data_ + hdr_len_; }
+  size_t payload_len() const { return len_ - hdr_len_; }
+  size_t slab_idx() const { return slab_; }
+  bool gap() const { return (flags_ & kGap) != 0; }
+  bool new_timestamp() const { return (flags_ & kNewTimestamp) != 0; }
+  bool restart() const { return (flags_ & kRestart) != 0; }
+  Frame frame() const {
+    Frame f{};
+    f.seq           = seq();
+    f.timestamp     = timestamp();
+    f.ssrc          = ssrc();
+    f.marker        = marker();
+    f.payload_type  = payload_type();
+    f.payload       = payload();
+    f.payload_len   = payload_len();
+    f.slab_idx      = slab_idx();
+    f.gap           = gap();
+    f.new_timestamp = new_timestamp();
+    f.restart       = restart();
+    return f;
+  }
+
+ private:
+  friend class Receiver;
+  // flags_ bits, computed by the recv thread at dispatch.
+  static constexpr uint8_t kGap          = 1;
+  static constexpr uint8_t kNewTimestamp = 2;
+  static constexpr uint8_t kRestart      = 4;
+  Packet(uint8_t* data, size_t len, size_t slab, uint16_t seq, uint16_t hdr_len, uint8_t flags)
+      : data_(data), len_(len), slab_(slab), seq_(seq), hdr_len_(hdr_len), flags_(flags) {}
+  static uint32_t be32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+           | (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+  }
+
+  uint8_t* data_;  // RTP header
+  size_t len_;
+  size_t slab_;
+  uint16_t seq_;
+  uint16_t hdr_len_;
+  uint8_t flags_;
 };
 
 class Receiver {
  public:
   using Hook = std::function<void(void*, const Frame&)>;
 
+  // Datagram ingest backend (select with set_ingest BEFORE start()):
+  //   kSocket     — UDP socket, recv()/recvmmsg() straight into staged slabs (default)
+  //   kPacketRing — AF_PACKET TPACKET_V3 mmap block ring on the interface. The kernel
+  //                 fills shared-memory blocks; the recv thread walks them with no
+  //                 per-packet syscall and no socket-buffer queueing, copying each RTP
+  //                 datagram once into a slab. Needs CAP_NET_RAW (see rtp_packet_ring.cpp).
+  //   kIoUring    — io_uring multishot recv on the UDP socket with a provided-buffer ring
+  //                 of slab slots: the completion's buffer id is the slab index, and the
+  //                 recv thread only enters the kernel when the completion queue is
+  //                 empty. Needs Linux 6.0+ (see rtp_uring.cpp).
+  //   kTcp        — RTP over TCP, RFC 4571 framing (2-byte length before each packet):
+  //                 listens on the address and takes one sender connection at a time.
+  //                 Reads up to set_tcp_read_bytes per call and copies each packet once
+  //                 into a slab; TCP delivers in order, so packets skip the jitter ring
+  //                 and go straight to the worker. A full pool stalls the reads rather
+  //                 than dropping, pushing back on the sender (see rtp_tcp.cpp).
+  enum class Ingest { kSocket, kPacketRing, kIoUring, kTcp };
+
+  // How the worker waits for jobs when the queue is empty (set_worker_wait BEFORE start()):
+  //   kCondvar  — condition_variable with a 1 ms timeout; the recv thread notifies on
+  //               every empty→non-empty transition (default)
+  //   kSpin     — never sleeps. Lowest latency, burns the worker core at 100%; only for
+  //               a dedicated, pinned core
+  //   kSpinPark — spins up to spin_iters polls, then parks on a futex. The recv thread
+  //               only issues a wake syscall when the worker is actually parked
+  //   kEventfd  — as kSpinPark, but parks in read() on an eventfd, so the wait could be
+  //               folded into an epoll set
+  enum class WorkerWait { kCondvar, kSpin, kSpinPark, kEventfd };
+  // Log2 buckets of reorder_histogram().
+  static constexpr size_t kReorderBuckets = 12;
+
   Receiver();
   ~Receiver();
 
   Receiver(const Receiver&)            = delete;
   Receiver& operator=(const Receiver&) = delete;
 
+  // Type-erased delivery: hook(hook_arg, frame) per packet, through std::function. Kept
+  // for existing callers; it runs on the Handler path below with an adapter handler.
   bool start(const std::string& local_addr, uint16_t local_port, void* hook_arg, Hook hook);
+  // Static delivery: the worker calls handler(const Packet&) per packet. The worker loop
+  // is instantiated for Handler, so the call — frame_handler::pull_data behind it in
+  // main.cpp — inlines into the job loop instead of going through std::function and a
+  // void* cast per packet. `handler` is referenced, not copied: it must outlive stop().
+  template <class Handler>
+  bool start(const std::string& local_addr, uint16_t local_port, Handler& handler) {
+    return start_worker(
+        local_addr, local_port, &handler, [](Receiver* rx, void* h) { rx->worker_loop(*static_cast<Handler*>(h)); },
+        [](Receiver* rx, void* h, const Job* jobs, size_t n) { rx->process_jobs(*static_cast<Handler*>(h), jobs, n); });
+  }
   void stop();
 
   // True network loss: packets the network/sender never delivered (force-advance miss),
   // plus ring-alias drops where the slot was already occupied by a different sequence.
   size_t net_lost_packets() const { return net_lost_packets_.load(std::memory_order_relaxed); }
-  // Backpressure drops: slab slot still owned by the worker thread (worker > kRingSize behind).
+  // Backpressure drops: no free slab to stage the datagram in (worker holds ~slab_count()).
   size_t slot_busy_drops() const { return slot_busy_drops_.load(std::memory_order_relaxed); }
-  // Backpressure drops: SPSC job queue full at dispatch (worker > kJobQueueSize behind).
+  // Backpressure drops: SPSC job queue full at dispatch (worker a whole pool behind).
   size_t queue_full_drops() const { return queue_full_drops_.load(std::memory_order_relaxed); }
   size_t total_drops() const { return net_lost_packets() + slot_busy_drops() + queue_full_drops(); }
+  // Relay fan-out (set_relay): datagrams handed to the kernel, summed over destinations;
+  // datagrams not sent (socket buffer full, or refused by the route) — the relay's drops,
+  // not the receiver's; and send syscalls, so relay_packets() / relay_calls() is how many
+  // datagrams each one carried.
+  size_t relay_packets() const { return relay_packets_.load(std::memory_order_relaxed); }
+  size_t relay_drops() const { return relay_drops_.load(std::memory_order_relaxed); }
+  size_t relay_calls() const { return relay_calls_.load(std::memory_order_relaxed); }
+  // Sender restarts re-synced to (see kResyncDepths): SSRC changes and sequence jumps
+  // far past the jitter window, in either direction.
+  size_t resyncs() const { return resyncs_.load(std::memory_order_relaxed); }
+  // Ingest syscall accounting: recv_datagrams() / recv_calls() is the average batch fill.
+  // With set_recv_batch(1) the two are equal; a fill well below the batch size means the
+  // batch is oversized for the arrival rate (harmless, only costs mmsghdr setup).
+  size_t recv_calls() const { return recv_calls_.load(std::memory_order_relaxed); }
+  size_t recv_datagrams() const { return recv_datagrams_.load(std::memory_order_relaxed); }
+  // Multi-socket only: datagrams a lane received but could not hand to the merge stage
+  // (lane queue full — the merge thread is > kLaneQueueSize behind that socket).
+  size_t merge_drops() const { return merge_drops_.load(std::memory_order_relaxed); }
+  // Dual-path receive (set_redundant_path), per path (0 = the start() socket): datagrams
+  // received, and sequence numbers the path skipped whether or not the other one covered
+  // them. Net loss after the merge stays in net_lost_packets().
+  size_t path_packets(size_t path) const { return path_packets_[path & 1].load(std::memory_order_relaxed); }
+  size_t path_lost(size_t path) const { return path_lost_[path & 1].load(std::memory_order_relaxed); }
+  // How much later path 1's copy of a packet arrives than path 0's, in µs (negative: path 1
+  // leads): smoothed over recent packets, and the widest seen since start().
+  int64_t path_skew_us() const { return path_skew_ns_.load(std::memory_order_relaxed) / 1000; }
+  int64_t path_skew_max_us() const { return path_skew_max_ns_.load(std::memory_order_relaxed) / 1000; }
+  // FEC (set_fec): parity packets received; packets rebuilt into the jitter ring; and
+  // packets of protected groups still missing when the ring gave up on them (in net_lost
+  // too), counted once however many groups they belong to.
+  size_t fec_packets() const { return fec_packets_.load(std::memory_order_relaxed); }
+  size_t fec_recovered() const { return fec_recovered_.load(std::memory_order_relaxed); }
+  size_t fec_unrecoverable() const { return fec_unrecoverable_.load(std::memory_order_relaxed); }
+  // Retransmission (set_retransmission): sequence numbers requested (repeats not counted);
+  // retransmitted packets that filled their hole; retransmissions that came too late or
+  // twice; and holes given up on at their deadline (counted in net_lost too).
+  size_t nack_requested() const { return nack_requested_.load(std::memory_order_relaxed); }
+  size_t rtx_recovered() const { return rtx_recovered_.load(std::memory_order_relaxed); }
+  size_t rtx_late() const { return rtx_late_.load(std::memory_order_relaxed); }
+  size_t nack_expired() const { return nack_expired_.load(std::memory_order_relaxed); }
+  // SRTP (set_srtp): packets dropped because they did not authenticate — forged, corrupt,
+  // keyed differently, or too short to carry a tag. Each leaves a hole in net_lost.
+  size_t srtp_auth_failures() const { return srtp_auth_failures_.load(std::memory_order_relaxed); }
+  // SRTP: authentic packets dropped as replays — an index already received, or older than
+  // the 4096-packet replay window. Not holes: the original was delivered (or lost) already.
+  size_t srtp_replays() const { return srtp_replays_.load(std::memory_order_relaxed); }
+  // Worker idle accounting: times the worker came back from a sleep (condvar, futex or
+  // eventfd; timeouts included), and empty-queue polls spent spinning.
+  size_t worker_wakeups() const { return worker_wakeups_.load(std::memory_order_relaxed); }
+  size_t worker_spins() const { return worker_spins_.load(std::memory_order_relaxed); }
+  // Run-to-completion accounting (set_run_to_completion): frames (RTP marker to marker)
+  // delivered on the recv thread, frames handed to the worker, and inline frames that
+  // went over the budget and switched the following frames to the worker.
+  size_t inline_frames() const { return inline_frames_.load(std::memory_order_relaxed); }
+  size_t handoff_frames() const { return handoff_frames_.load(std::memory_order_relaxed); }
+  size_t rtc_fallbacks() const { return rtc_fallbacks_.load(std::memory_order_relaxed); }
+  // Jobs published to the worker and not yet taken by it: how far the worker lags the
+  // jitter ring, in packets. Callable from the handler (worker thread) or any other.
+  size_t queued_jobs() const {
+    return (job_tail_.load(std::memory_order_acquire) - job_head_.load(std::memory_order_relaxed)) &
+           (job_queue_size_ - 1);
+  }
+  // Frame admission (set_frame_admission): frames shed whole, and their packets.
+  size_t shed_frames() const { return shed_frames_.load(std::memory_order_relaxed); }
+  size_t shed_packets() const { return shed_packets_.load(std::memory_order_relaxed); }
+  // Jitter ring depth in effect (moves with set_jitter_depth(min, max)), and reordered
+  // arrivals by how far behind the newest sequence number they came: bucket 0 is 1
+  // packet, bucket k is [2^k, 2^(k+1)), the last is open-ended. late_packets() are those
+  // that came after the ring had already given up on them (counted in net_lost too).
+  size_t jitter_depth() const { return jitter_depth_.load(std::memory_order_relaxed); }
+  std::array<size_t, kReorderBuckets> reorder_histogram() const {
+    std::array<size_t, kReorderBuckets> h;
+    for (size_t i = 0; i < kReorderBuckets; ++i) h[i] = reorder_hist_[i].load(std::memory_order_relaxed);
+    return h;
+  }
+  size_t late_packets() const { return late_packets_.load(std::memory_order_relaxed); }
 
   // Releases a slab slot previously delivered via the hook's Frame::slab_idx.
   // The hook's owner is responsible for calling this once the slab's bytes are no
   // longer needed (e.g., at frame_handler::restart). Until called, recv will not
-  // reuse the slot — see Slot::in_worker.
+  // reuse the slab — see slab_gen_. Call from the handler's thread only.
+  // A jumbo datagram occupies a run of consecutive slabs; its index is the first one and
+  // the whole run is freed here.
   void release_slab(size_t slab_idx) {
-    if (slab_idx < kRingSize) ring_[slab_idx].in_worker.store(0, std::memory_order_release);
+    if (slab_idx >= slab_count_) return;
+    const uint64_t gen = slab_gen_[slab_idx].load(std::memory_order_relaxed);
+    for (size_t k = slab_run_[slab_idx]; k-- > 0;) slab_freed_[slab_idx + k].store(gen, std::memory_order_release);
+  }
+  // Releases the slab delivered in `slab_idx` AND every slab delivered before it, with
+  // one store. For a hook that, like frame_handler, is done with everything up to the
+  // packet it is on — it has released the rest individually or holds it until now — this
+  // replaces ~1300 release_slab() calls per frame. Call from the hook's thread only.
+  void release_through(size_t slab_idx) {
+    if (slab_idx >= slab_count_) return;
+    const uint64_t gen = slab_gen_[slab_idx].load(std::memory_order_relaxed);
+    if (gen > released_gen_.load(std::memory_order_relaxed)) released_gen_.store(gen, std::memory_order_release);
   }
 
-  void set_jitter_depth(size_t depth) { jitter_depth_ = depth; }
+  // Packets the jitter ring waits for a missing sequence number before force-advancing
+  // past it. With max_depth > depth the depth adapts in [depth, max_depth] to the
+  // reordering actually seen: it grows at once when a reordered packet arrives more than
+  // half the current depth late, and halves at most once per second while the last
+  // second's reordering needed less — on a clean link a loss stalls delivery for only
+  // `depth` packets. Starts at max_depth. Apply BEFORE start().
+  void set_jitter_depth(size_t depth, size_t max_depth = 0) {
+    jitter_min_ = depth ? depth : 1;
+    jitter_max_ = std::max(max_depth, jitter_min_);
+  }
   void set_recv_buf_size(int bytes) { rcvbuf_size_ = bytes; }
+  // Ingest backend (see Ingest) and the per-backend settings below. Apply BEFORE start().
+  void set_ingest(Ingest mode) { ingest_ = mode; }
+  // kPacketRing geometry. `iface` empty = the interface owning local_addr (all interfaces
+  // for 0.0.0.0). The kernel hands a block to the recv thread when it is full or after
+  // retire_ms, so block_bytes / bitrate bounds the added latency: 256 KB ≈ 2.5 ms at
+  // 800 Mbps, cut to ~1 ms by the default retire timeout. block_bytes must be a
+  // power-of-two multiple of the page size.
+  void set_packet_ring(const std::string& iface, size_t block_bytes = 256 * 1024, size_t block_count = 128,
+                       unsigned retire_ms = 1) {
+    ring_iface_       = iface;
+    ring_block_bytes_ = block_bytes;
+    ring_block_count_ = block_count;
+    ring_retire_ms_   = retire_ms;
+  }
+  // kIoUring: slabs kept on the provided-buffer ring (power of two, <= 32768). They are
+  // staged, so they count against the slab pool; 512 absorbs ~7 ms of 4K@60 arrivals.
+  // start() fails for any other size, and — the buffer id being 16 bits — for a pool of
+  // more than 65536 slabs.
+  void set_uring_buffers(size_t n) { uring_buffers_ = n; }
+  // kTcp: bytes asked for per recv() (at least 128 KB). Under load each call returns this
+  // much — ~370 packets of 1400 B at the 512 KB default.
+  void set_tcp_read_bytes(size_t n) { tcp_read_bytes_ = n; }
+  // Datagrams pulled per recvmmsg() call (1 = plain recv(), the default). At 4K@60
+  // (~75k packets/s) one syscall per datagram is the main cost on the recv core; a batch
+  // of 32–64 amortises it. timeout_us = 0 returns as soon as at least one datagram is
+  // queued (MSG_WAITFORONE) — the batch only fills with what the kernel already holds,
+  // so no latency is added. timeout_us > 0 waits up to that long for the batch to fill
+  // (SO_RCVTIMEO bounds each wait, so a stream tail cannot block the loop). Apply
+  // BEFORE calling start().
+  void set_recv_batch(size_t n, int timeout_us = 0) {
+    recv_batch_            = n ? n : 1;
+    recv_batch_timeout_us_ = timeout_us;
+  }
+  // UDP_GRO on the socket (kSocket ingest only). A sender using UDP GSO — or loopback —
+  // then delivers up to 64 KB of back-to-back datagrams per recvmsg(); each segment
+  // still gets its own slab and sequence check. The kernel scatters the super-datagram
+  // over per-segment slabs once the segment size is learned, so in steady state no
+  // segment is copied. Overrides set_recv_batch (one recvmsg per super-datagram).
+  void set_udp_gro(bool on) { udp_gro_ = on; }
+  // Receive on n SO_REUSEPORT sockets bound to the same address (kSocket ingest only;
+  // n <= 1 keeps the single socket). A reuseport BPF program spreads the one RTP flow
+  // over the sockets by sequence number (seq % n) — the kernel's default 4-tuple hash
+  // would put the whole flow on one socket — so each socket's queue and recv thread
+  // carries 1/n of the packet rate. Lane threads receive (recvmmsg, set_recv_batch)
+  // into disjoint slab partitions; the recv thread becomes a merge stage that feeds the
+  // lanes' datagrams back into sequence order before the jitter ring. `cpus[i]` pins
+  // lane i (missing entries or -1 = unpinned). Excludes set_udp_gro. Apply BEFORE start().
+  void set_recv_sockets(size_t n, std::vector<int> cpus = {}) {
+    recv_sockets_ = n ? n : 1;
+    lane_cpus_    = std::move(cpus);
+  }
+  // SMPTE 2022-7 seamless protection: the same RTP stream (identical sequence numbers)
+  // also arrives on a second network, received on its own socket bound to addr:port. The
+  // start() socket is path 0, this one path 1; each gets a lane as in set_recv_sockets
+  // (`cpus` of that call pins them) and the merge stage feeds both into the jitter ring,
+  // where each sequence number is taken from whichever copy arrives first and the other
+  // is dropped as a duplicate. A packet lost on one path is thus covered as long as the
+  // jitter depth spans the path differential (path_skew_us()); an adaptive depth
+  // (set_jitter_depth) grows to it. kSocket ingest only; excludes set_recv_sockets(n > 1)
+  // and set_udp_gro. An empty addr disables it. Apply BEFORE start().
+  void set_redundant_path(const std::string& addr, uint16_t port) {
+    redundant_addr_ = addr;
+    redundant_port_ = port;
+  }
+  // SMPTE 2022-1 FEC: XOR parity packets for the stream (2022-1 FEC header, column and/or
+  // row) arrive at the start() address on `port`, and on `row_port` if the sender puts
+  // rows on a port of their own (2022-1 uses media port + 2 and + 4; 0 = none). A packet
+  // that is the only one missing from a parity group is rebuilt into a fresh slab and
+  // enters the jitter ring as if it had arrived; a rebuilt packet can complete a group
+  // of the other dimension. The jitter depth must cover a group's span plus the parity's
+  // delay behind it (a column's parity follows its L x D matrix), or the ring gives up
+  // first. Media packets over 1536 bytes are not protected. Single-socket
+  // kSocket ingest only. port 0 disables. Apply BEFORE start().
+  void set_fec(uint16_t port, uint16_t row_port = 0) {
+    fec_port_     = port;
+    fec_row_port_ = row_port;
+  }
+  // RFC 4585 generic NACK + RFC 4588 retransmission. A sequence number still missing once
+  // kNackReorder newer packets have arrived is requested in an RTCP NACK (reduced-size,
+  // RFC 5506) sent to nack_addr:nack_port, and the jitter ring holds the hole — past
+  // jitter_depth, up to half the ring — until the copy arrives or `deadline_ms` after the
+  // loss was seen; only then is it counted lost and delivered past. Pass about one frame
+  // period so a lost packet never costs more than a frame of latency. The request is
+  // repeated once at half the deadline. Retransmissions arrive on the media socket as
+  // RTX packets (SSRC-multiplexed, payload type `rtx_pt`, original sequence number in
+  // front of the payload) and are unwrapped in place into the original packet. The recv
+  // thread only queues requests; a thread of its own sends them. Not with set_recv_sockets
+  // (n > 1) or set_redundant_path. Empty nack_addr disables. Apply BEFORE start().
+  void set_retransmission(const std::string& nack_addr, uint16_t nack_port, uint8_t rtx_pt, double deadline_ms) {
+    nack_addr_        = nack_addr;
+    nack_port_        = nack_port;
+    rtx_pt_           = rtx_pt & 0x7F;
+    nack_deadline_ms_ = deadline_ms;
+  }
+  // SRTP (RFC 3711 / RFC 7714): every packet is authenticated and decrypted in place in
+  // its slab on the recv thread, before the jitter ring sees it, so the hook gets plain
+  // RTP and packets that fail authentication are dropped. `key_salt` is the master key
+  // (16 bytes) followed by the master salt (14 bytes for AES-CM, 12 for GCM), as in SDES
+  // inline keying. AES, GHASH and SHA-1 run on the CPU's crypto extensions where present
+  // (rtp_srtp.hpp). Not with set_fec or set_retransmission. Empty disables. Apply BEFORE
+  // start().
+  void set_srtp(srtp::Suite suite, const uint8_t* key_salt, size_t len) {
+    srtp_suite_ = suite;
+    srtp_key_.assign(key_salt, key_salt + len);
+  }
+  // Relay fan-out: the worker forwards every packet it delivers — in order, as the hook
+  // sees it (recovered, decrypted, padding stripped) — to each IPv4 `dests` address:port,
+  // straight from its slab, before the hook gets it. One sendmmsg() per worker batch, runs
+  // of equal-size packets coalesced per destination with UDP GSO (rtp_relay.cpp); the
+  // hook may release the slab as soon as it has it. Works with a hook that only releases
+  // (start() without one: ingest once, fan out, no parsing). Sends never block; what a
+  // full socket buffer refuses is counted in relay_drops(). Under set_run_to_completion,
+  // frames parsed inline go out a packet per call. Empty disables. Apply BEFORE start().
+  void set_relay(std::vector<std::pair<std::string, uint16_t>> dests) { relay_dests_ = std::move(dests); }
   // Linux CPU affinity for the recv and worker threads. -1 (default) leaves the OS
   // scheduler in charge. Setting to distinct CPU indices prevents the threads from
   // preempting each other under load — important at high bitrates where each thread
   // approaches 100% of one core. Apply BEFORE calling start().
   void set_recv_cpu(int cpu) { recv_cpu_ = cpu; }
   void set_worker_cpu(int cpu) { worker_cpu_ = cpu; }
+  // Receive capacity, fixed at start(). An explicit slab count wins; otherwise the pool
+  // holds hold_ms of the stream: packets/s × hold_ms × slabs per packet, where hold_ms
+  // covers what the hook keeps (frame_handler: the frame in flight, decode lag and tail
+  // events — see the pool note below). The defaults give the 4K@60 1.7 bpp pool of 16384
+  // slabs; a 400 Mbps 1080p stream needs under half of that, 8K@60 about four times.
+  // The jitter ring and the job queue follow the pool (next power of two).
+  struct Capacity {
+    size_t slabs        = 0;     // 0 = derive from bitrate_mbps (16384 if that is 0 too)
+    size_t max_datagram = 9216;  // larger datagrams are dropped; <= 1536 never spills
+    double bitrate_mbps = 0;     // on the wire, RTP headers included
+    double frame_rate   = 60;
+    double hold_ms      = 200;
+    size_t packet_bytes = 1400;  // typical datagram: packets/s and slabs per packet
+  };
+  void set_capacity(const Capacity& c) { capacity_ = c; }
+  // Slab pool size start() allocates for the current Capacity (at least 1024).
+  size_t slab_count() const;
+  size_t pool_bytes() const { return slab_count() * kSlabBytes; }
+  // Runaway cap for packets held by the hook (frame_handler::set_held_slab_cap), from
+  // the same Capacity: 2.5 frames of packets when the bitrate is known, else 3/16 of the
+  // pool (3072 of 16384). Never more than half the pool, so one frame missing its EOC
+  // cannot starve the next.
+  size_t held_slab_cap() const;
+  // Slab pool backing, applied when start() maps the pool (rtp_slab_pool.cpp). The pool
+  // is an anonymous mapping committed on first touch, so start() does not wait for it:
+  //   kSmall   — 4 KB pages
+  //   kThp     — transparent huge pages (the default; needs THP "madvise" or "always")
+  //   kHugeTlb — 2 MB pages reserved from vm.nr_hugepages at start(); falls back to kThp
+  //              with a warning when the pool is short
+  // lock mlocks the pool as it is faulted in (needs RLIMIT_MEMLOCK >= pool_bytes(); a
+  // warning and unlocked otherwise). prefault populates it from a background idle-priority
+  // thread, front first, so steady-state receives do not take the faults either.
+  enum class SlabPages { kSmall, kThp, kHugeTlb };
+  void set_slab_memory(SlabPages pages, bool lock = false, bool prefault = true) {
+    slab_pages_    = pages;
+    slab_lock_     = lock;
+    slab_prefault_ = prefault;
+  }
+  // Backing in use after start() (kThp after a kHugeTlb fallback), and pool bytes the
+  // prefault thread has populated so far.
+  SlabPages slab_pages() const { return slab_map_pages_; }
+  size_t slab_prefaulted_bytes() const { return slab_prefaulted_.load(std::memory_order_relaxed); }
+  // spin_iters only applies to kSpinPark / kEventfd (0 = park as soon as the queue is
+  // empty). One poll is a pause instruction plus two loads, ~10–50 ns.
+  void set_worker_wait(WorkerWait mode, size_t spin_iters = 4096) {
+    worker_wait_ = mode;
+    worker_spin_ = spin_iters;
+  }
+  // SO_BUSY_POLL on the UDP socket(s): a blocking receive polls the NIC queue for up to
+  // usec before sleeping, skipping the interrupt→softirq→wakeup path (0 = off). prefer
+  // sets SO_PREFER_BUSY_POLL (keeps softirq processing off while busy polling succeeds);
+  // budget > 0 sets SO_BUSY_POLL_BUDGET. Raising above net.core.busy_read needs
+  // CAP_NET_ADMIN; failures are logged and ignored. kSocket ingest. Apply BEFORE start().
+  void set_busy_poll(int usec, bool prefer = false, int budget = 0) {
+    busy_poll_usec_   = usec;
+    busy_poll_prefer_ = prefer;
+    busy_poll_budget_ = budget;
+  }
+  // Run-to-completion: the recv thread calls the handler itself as each packet leaves the
+  // jitter ring, instead of queueing it for the worker, so parsing runs on the core the
+  // packet arrived on — no cross-core hand-off, no job queue, and a precinct is parsed
+  // as soon as its last packet is in order. For low-core targets and latency-critical
+  // setups. While the recv thread parses it is not receiving, so a frame whose handler
+  // time exceeds budget_us switches delivery to the worker from the next frame; after
+  // kRtcRetryFrames frames, and once the worker has drained, the recv thread takes over
+  // again. Paths only change at frame boundaries (RTP marker), so the handler still sees
+  // every packet in order and never from two threads at once. Apply BEFORE start().
+  void set_run_to_completion(bool on, unsigned budget_us = 5000) {
+    rtc_           = on;
+    rtc_budget_us_ = budget_us;
+  }
+  // Frame-aware admission under worker backpressure. At each frame's first in-order
+  // packet (a new RTP timestamp) the recv thread checks how many packets are queued for
+  // the worker and not yet processed; at or above pool_fraction × slab_count() the whole
+  // frame is shed — every packet with its timestamp is freed on the spot and never
+  // queued — otherwise the whole frame is admitted, whatever the backlog does meanwhile.
+  // Overload then skips a few frames cleanly instead of truncating a run of them, and the
+  // worker gets the skipped frames' parse time back. The handler sees the next admitted
+  // frame start on a new timestamp without a gap flag. With pool_fraction ≤ 0.5 and
+  // frames under half the pool, an admitted frame never meets a full job queue. 0 (the
+  // default) admits everything. Apply BEFORE start().
+  void set_frame_admission(double pool_fraction) { admit_fraction_ = pool_fraction > 0 ? pool_fraction : 0; }
 
  private:
-  // 16384 slots × 9216 bytes ≈ 151 MB. The chain-reader keeps every packet's slab
-  // "in_worker" for an entire frame (~1300 packets at 4K@60 1.7bpp), so the ring must
+  // Pool sizing (Capacity's defaults): one slab per packet. The chain-reader keeps every packet's slab
+  // held for an entire frame (~1300 packets at 4K@60 1.7bpp), so the ring must
   // absorb (frames-in-flight + arrival-vs-decode lag + tail events) × frame size.
   // 4096 (~3.1 frames at 1.7bpp) was NOT enough: with chase running laggard
   // (mh->done 1.7–2.5 slots) the steady margin was ~0.4 frames, and any tail event
   // (50 ms decode timeout, a 21.5 ms encoder frame delivery, a beat stall) wrapped
-  // recv onto in_worker slots. Every such discard is counted TWICE in the stats —
+  // recv onto held slabs. Every such discard is counted TWICE in the stats —
   // once as slot_busy at the collision, once as net_lost when the head force-advances
   // past the hole — which is why a clean wire shows net_lost == slot_busy exactly
   // (silicon 2026-07-14: 330,819 == 330,819 over 25 min at 1.7 bpp with a
   // 0-gap/9.47M-packet wire capture; ~0.59% of frames degraded from self-discards).
-  // 16384 ≈ 12.5 frames at 1.7 bpp absorbs ~200 ms of worker hold before wrapping.
-  static constexpr size_t kRingSize     = 16384;
-  static constexpr size_t kSlotBytes    = 9216;
-  static constexpr size_t kJobQueueSize = kRingSize;
+  // 16384 ≈ 12.5 frames at 1.7 bpp absorbs ~200 ms of worker hold before wrapping —
+  // hence Capacity::hold_ms = 200 for derived pools.
+  static constexpr size_t kDefaultSlabs = 16384;
+  static constexpr size_t kMinSlabs     = 1024;
+  // Jobs the worker takes per dequeue: one job_tail_ acquire and one job_head_ release
+  // per run instead of per packet.
+  static constexpr size_t kWorkerBatch = 32;
+  // Run-to-completion: frames handed to the worker after a budget overrun before the recv
+  // thread tries delivering inline again (~1 s at 60 fps).
+  static constexpr size_t kRtcRetryFrames = 60;
+  // A sequence jump of this many jitter depths (at most 16384) is a discontinuity, not
+  // loss to force-advance through one slot at a time: a restarted sender or a re-dial
+  // with an unrelated sequence base. An SSRC change always is one.
+  static constexpr size_t kResyncDepths = 8;
+  // Adaptive jitter depth: never above this (the resync threshold is kResyncDepths of the
+  // maximum), re-evaluated every kJitterIntervalMs, the clock read every kJitterClockMask+1
+  // packets.
+  static constexpr size_t kJitterMaxDepth     = 2048;
+  static constexpr unsigned kJitterIntervalMs = 1000;
+  static constexpr size_t kJitterClockMask    = 63;
+  // Slab storage is decoupled from ring position: the recv thread stages a free slab
+  // per pending recv() and the kernel writes the datagram into it directly; the ring slot
+  // for its sequence number then just records which slab holds it. Duplicate, late,
+  // alias and out-of-window datagrams never touch the ring, so their slab stays staged
+  // for the next recv() — no copy in any path.
+  //
+  // A slab is kSlabBytes — a 1500-MTU RTP datagram (≤ 1472 B) plus headroom — so 12+
+  // frames of history fit in ~25 MB instead of the 151 MB of 9216-byte slots, ~85% of
+  // which was never touched while held. Larger datagrams (jumbo frames) take a run of
+  // consecutive slabs, which is contiguous memory. Receives scatter into [staged run,
+  // spill]; the recv thread stages runs as long as the last datagram needed, so a jumbo
+  // stream lands in place and only a size change copies out of the spill buffer. A run
+  // is trimmed to the datagram's length before it is parked, so held memory tracks the
+  // bytes actually received whatever the packet size.
+  static constexpr size_t kSlabBytes = 1536;
+  static constexpr size_t kNoSlab    = SIZE_MAX;
+  // Free-slab scan window per staging attempt. frame_handler releases whole frames in
+  // arrival order, so the slab after the cursor is almost always the oldest — and free.
+  static constexpr size_t kSlabProbe = 64;
 
   struct Slot {
     bool filled      = false;
     uint16_t seq     = 0;
     uint16_t hdr_len = 0;  // RTP header length (parsed once in handle_dgram)
     size_t len       = 0;
-    std::atomic<uint8_t> in_worker{0};  // 0 = recv may write, 1 = worker holds slab bytes
+    size_t slab      = 0;  // slab pool index holding this packet's bytes
   };
 
   struct Job {
@@ -98,48 +549,386 @@ class Receiver {
     size_t len;
     uint16_t seq;
     uint16_t hdr_len;
+    uint8_t flags;  // Packet::kGap | kNewTimestamp | kRestart
   };
 
   void recv_loop();
-  void worker_loop();
-  void handle_dgram(uint8_t* data, size_t len);
+  void recv_loop_batched();
+  void recv_loop_gro();
+  // AF_PACKET backend (rtp_packet_ring.cpp)
+  bool open_packet_ring(const std::string& local_addr, uint16_t local_port);
+  void close_packet_ring();
+  void recv_loop_packet_ring();
+  // io_uring backend (rtp_uring.cpp)
+  struct UringState;
+  bool open_uring();
+  void close_uring();
+  void provide_slab(size_t slab);
+  void publish_provided();
+  void recv_loop_uring();
+  // RFC 4571 TCP backend (rtp_tcp.cpp)
+  int open_tcp_listener(const sockaddr_in& addr);
+  size_t acquire_stream_slab(size_t len);
+  void recv_loop_tcp();
+  bool handle_inorder(uint8_t* data, size_t len, size_t slab);
+  // SO_REUSEPORT multi-socket receive (rtp_reuseport.cpp)
+  struct Lane;
+  bool open_lanes(const sockaddr_in& addr, const sockaddr_in* redundant);
+  void start_lanes();
+  void stop_lanes();
+  void close_lanes();
+  void lane_loop(Lane& lane);
+  void merge_loop();
+  void note_path_seq(Lane& lane, uint16_t seq);
+  // SMPTE 2022-1 FEC (rtp_fec.cpp)
+  struct FecState;
+  bool open_fec(const sockaddr_in& addr);
+  void start_fec();
+  void stop_fec();
+  void close_fec();
+  void fec_loop();
+  void fec_store(uint16_t seq, const uint8_t* data, size_t len);
+  void fec_poll();
+  // RFC 4585 NACK / RFC 4588 RTX (rtp_nack.cpp)
+  struct NackState;
+  bool open_nack();
+  void start_nack();
+  void stop_nack();
+  void close_nack();
+  void nack_loop();
+  void nack_gap(uint16_t first, size_t count);
+  void nack_issue();
+  bool nack_hold(uint16_t seq, bool room);
+  void nack_reset();
+  bool unwrap_rtx(uint8_t* data, size_t& len);
+  // SRTP (rtp_srtp.cpp)
+  struct SrtpState;
+  bool open_srtp();
+  void close_srtp();
+  bool srtp_unprotect(uint8_t* data, size_t& len);
+  // Relay fan-out (rtp_relay.cpp)
+  struct RelayState;
+  bool open_relay();
+  void close_relay();
+  void relay_jobs(const Job* jobs, size_t n);
+  int open_udp_socket(const sockaddr_in& addr, bool reuseport);
+  static void pin_thread(std::thread& t, int cpu, const char* name);
+  using WorkerEntry  = void (*)(Receiver*, void*);
+  using DeliverEntry = void (*)(Receiver*, void*, const Job*, size_t);
+  bool start_worker(const std::string& local_addr, uint16_t local_port, void* handler, WorkerEntry entry,
+                    DeliverEntry deliver);
+  template <class Handler>
+  void worker_loop(Handler& handler);
+  template <class Handler>
+  void process_jobs(Handler& handler, const Job* jobs, size_t n);
+  void worker_idle(size_t& spins);
+  void worker_park();
+  void wake_worker();
+  bool handle_dgram(uint8_t* data, size_t len, size_t slab);
+  bool resync(uint16_t seq, uint32_t ssrc, int16_t diff);
+  void note_reorder(size_t distance);
+  void adapt_jitter();
+  bool handle_received(uint8_t* data, const uint8_t* spill, size_t len, size_t slab);
+  void join_spill(size_t run, const uint8_t* data, size_t cap, const uint8_t* spill, size_t len);
+  void trim_run(size_t slab, size_t len);
+  size_t acquire_in(size_t base, size_t count, size_t& cursor, size_t run);
+  // Returns a run the staging side still owns (never dispatched) to the pool.
+  void free_slab(size_t slab) {
+    for (size_t k = slab_run_[slab]; k-- > 0;) slab_gen_[slab + k].store(0, std::memory_order_release);
+  }
+  size_t acquire_slab(size_t run = 1) { return acquire_in(0, slab_count_, slab_cursor_, run); }
+  static size_t slabs_for(size_t len) { return len ? (len + kSlabBytes - 1) / kSlabBytes : 1; }
+  // Bytes the kernel may write at slab_ptr(slab) — the staged run's length.
+  size_t slab_capacity(size_t slab) const { return slab == kNoSlab ? kSlabBytes : slab_run_[slab] * kSlabBytes; }
+  uint8_t* slab_ptr(size_t slab) { return slab_ + slab * kSlabBytes; }
+  bool allocate_pool();
+  // Slab pool memory (rtp_slab_pool.cpp)
+  bool map_slabs(size_t bytes);
+  void unmap_slabs();
+  void prefault_slabs();
   void release_in_order();
   void dispatch(size_t slab_idx, size_t len, uint16_t seq, uint16_t hdr_len);
-  void process_job(const Job& j);
-  bool enqueue_job(const Job& j);
-  bool dequeue_job(Job& out);
+  bool admit(uint32_t stamp);
+  bool rtc_begin_frame();
+  void rtc_deliver(const Job& j, bool marker);
+  bool stage_job(const Job& j);
+  void publish_jobs();
+  size_t dequeue_jobs(Job* out, size_t max);
 
   int sock_fd_ = -1;
   std::thread thread_;
   std::thread worker_;
   std::atomic<bool> running_{false};
 
+  // Adapter that runs the type-erased Hook on the Handler path.
+  struct HookHandler {
+    Receiver* rx;
+    void operator()(const Packet& p) const {
+      if (rx->hook_) {
+        rx->hook_(rx->hook_arg_, p.frame());
+      } else {
+        rx->release_slab(p.slab_idx());  // no hook: recv can recycle the slab at once
+      }
+    }
+  };
   void* hook_arg_ = nullptr;
   Hook hook_;
+  HookHandler hook_handler_{this};
+  // Handler passed to start() and its job-batch entry point, for run-to-completion.
+  void* handler_        = nullptr;
+  DeliverEntry deliver_ = nullptr;
+
+  size_t jitter_min_         = 64;
+  size_t jitter_max_         = 64;
+  int rcvbuf_size_           = 16 * 1024 * 1024;
+  size_t recv_batch_         = 1;
+  int recv_batch_timeout_us_ = 0;
+  bool udp_gro_              = false;
+  bool gro_active_           = false;  // UDP_GRO accepted by the kernel at start()
+  int recv_cpu_              = -1;
+  int worker_cpu_            = -1;
+  Ingest ingest_             = Ingest::kSocket;
+  WorkerWait worker_wait_    = WorkerWait::kCondvar;
+  size_t worker_spin_        = 4096;
+  int busy_poll_usec_        = 0;
+  bool busy_poll_prefer_     = false;
+  int busy_poll_budget_      = 0;
+  bool rtc_                  = false;
+  unsigned rtc_budget_us_    = 5000;
+  double admit_fraction_     = 0;
+
+  std::string ring_iface_;
+  size_t ring_block_bytes_ = 256 * 1024;
+  size_t ring_block_count_ = 128;
+  unsigned ring_retire_ms_ = 1;
+  int ring_fd_             = -1;
+  uint8_t* ring_map_       = nullptr;
+  uint32_t ring_dst_addr_  = 0;  // network order; 0 = any
+  uint16_t ring_dst_port_  = 0;  // host order
 
-  size_t jitter_depth_ = 64;
-  int rcvbuf_size_     = 16 * 1024 * 1024;
-  int recv_cpu_        = -1;
-  int worker_cpu_      = -1;
+  size_t uring_buffers_ = 512;
+  UringState* uring_    = nullptr;
+
+  size_t tcp_read_bytes_ = 512 * 1024;
+
+  size_t recv_sockets_ = 1;
+  std::vector<int> lane_cpus_;
+  std::string redundant_addr_;
+  uint16_t redundant_port_ = 0;
+  Lane* lanes_             = nullptr;  // while multi-socket or dual-path receive is active
+  size_t lane_count_       = 0;        // entries in lanes_
+
+  uint16_t fec_port_     = 0;
+  uint16_t fec_row_port_ = 0;
+  FecState* fec_         = nullptr;
+
+  std::string nack_addr_;
+  uint16_t nack_port_      = 0;
+  uint8_t rtx_pt_          = 0;
+  double nack_deadline_ms_ = 0;
+  NackState* nack_         = nullptr;
+  srtp::Suite srtp_suite_  = srtp::Suite::kAesCm128HmacSha1_80;
+  std::vector<uint8_t> srtp_key_;
+  SrtpState* srtp_         = nullptr;
+  std::vector<std::pair<std::string, uint16_t>> relay_dests_;
+  RelayState* relay_       = nullptr;
+  uint8_t media_pt_        = 0;  // recv thread: the stream's payload type, restored on RTX
+  size_t hold_limit_       = 0;  // packets past a held hole before it is given up anyway
+
+  Capacity capacity_;
+  // Effective sizes, set from capacity_ by allocate_pool() at start().
+  size_t ring_size_      = 0;  // power of two
+  size_t slab_count_     = 0;
+  size_t job_queue_size_ = 0;  // power of two
+  size_t max_datagram_   = 0;
+  size_t max_run_        = 1;  // slabs_for(max_datagram_)
+  size_t spill_bytes_    = 0;  // max_datagram_ past the first slab
+
+  SlabPages slab_pages_ = SlabPages::kThp;
+  bool slab_lock_       = false;
+  bool slab_prefault_   = true;
 
   std::unique_ptr<Slot[]> ring_;
-  std::vector<uint8_t> slab_;
-  bool started_      = false;
-  uint16_t next_seq_ = 0;
-  size_t pending_    = 0;
+  // Slab pool, slab_count_ × kSlabBytes inside the mapping [slab_map_, + slab_map_bytes_)
+  // (huge-page modes align it to 2 MB within a larger mapping).
+  uint8_t* slab_         = nullptr;
+  void* slab_map_        = nullptr;
+  size_t slab_map_bytes_ = 0;
+  // How the current mapping was made; start() remaps when set_slab_memory() changed.
+  SlabPages slab_map_pages_ = SlabPages::kSmall;
+  SlabPages slab_map_asked_ = SlabPages::kSmall;
+  bool slab_map_locked_     = false;
+  std::thread prefault_;
+  std::atomic<size_t> slab_prefaulted_{0};
+  // Slab ownership by delivery generation. Each dispatched slab is stamped with the next
+  // generation (1, 2, …, in delivery order). The hook frees it either individually
+  // (slab_freed_[i] = its generation) or in bulk (released_gen_ = the generation of the
+  // last slab it is done with), so slab i is free iff
+  //   slab_gen_[i] <= released_gen_  ||  slab_freed_[i] == slab_gen_[i]
+  // with 0 = never handed out (or freed by the staging side) and kSlabStaged = owned by
+  // the staging side: staged for a receive, parked in the ring or queued for merging.
+  //
+  // The arrays are split by writer and cache-line aligned: slab_gen_ is written only by
+  // the staging threads (recv/merge and, for their partitions, the lanes), slab_freed_
+  // and released_gen_ only by the worker — before, recv's "held" flag store and the
+  // worker's release store hit the same lines on two pinned cores. At a frame's EOC the
+  // worker now writes one released_gen_ instead of a flag per packet.
+  static constexpr uint64_t kSlabStaged = UINT64_MAX;
+  struct CacheLineDelete {
+    void operator()(std::atomic<uint64_t>* p) const { ::operator delete[](p, std::align_val_t{64}); }
+  };
+  using GenArray = std::unique_ptr<std::atomic<uint64_t>[], CacheLineDelete>;
+  GenArray slab_gen_;
+  GenArray slab_freed_;
+  uint64_t next_gen_ = 1;  // recv (or merge) thread: next dispatch generation
+  // Run length (slabs) of the datagram starting at each slab; written by the staging
+  // thread before the slab is handed on, read by release_slab().
+  std::unique_ptr<uint8_t[]> slab_run_;
+  size_t slab_cursor_ = 0;
+  size_t stage_run_   = 1;  // run length the recv thread stages (last datagram's)
+  bool started_       = false;
+  uint16_t next_seq_  = 0;
+  size_t pending_     = 0;
+  // Last packet handed to the hook (recv thread), for Frame::gap and new_timestamp.
+  bool delivered_any_  = false;
+  uint16_t last_seq_   = 0;
+  uint32_t last_stamp_ = 0;
+  // Discontinuity detection (recv thread): the stream's SSRC, the jump that counts as a
+  // restart, a backward jump awaiting its confirming packet, and a restart to flag on
+  // the next delivered packet.
+  uint32_t ssrc_             = 0;
+  int resync_jump_           = 0;
+  bool resync_probe_         = false;
+  uint16_t resync_probe_seq_ = 0;
+  bool restart_pending_      = false;
+  // Reorder tracking (recv thread): the newest sequence number seen, whether the depth
+  // adapts, packets until the next clock read, the interval's start and the farthest
+  // reorder seen in it.
+  uint16_t high_seq_         = 0;
+  bool jitter_adaptive_      = false;
+  size_t jitter_clock_       = 0;
+  size_t jitter_window_max_  = 0;
+  size_t jitter_lo_          = 0;  // effective bounds, set at start()
+  size_t jitter_hi_          = 0;
+  std::chrono::steady_clock::time_point jitter_t0_;
+  // Run-to-completion state (recv thread): delivering inline, inside a frame, handler
+  // time so far in the current inline frame, frames left before retrying inline, and
+  // jobs ever staged for the worker (compared against worker_done_).
+  bool rtc_inline_       = false;
+  bool rtc_in_frame_     = false;
+  uint64_t rtc_frame_ns_ = 0;
+  size_t rtc_retry_left_ = 0;
+  size_t jobs_handed_    = 0;
+  // Frame admission (recv thread): the worker backlog that sheds a frame (0 = off), and
+  // the timestamp of the frame being admitted or shed.
+  size_t admit_limit_   = 0;
+  bool admit_any_       = false;
+  bool admit_shed_      = false;
+  uint32_t admit_stamp_ = 0;
 
   std::atomic<size_t> net_lost_packets_{0};
   std::atomic<size_t> slot_busy_drops_{0};
   std::atomic<size_t> queue_full_drops_{0};
+  std::atomic<size_t> relay_packets_{0};  // written by the delivering thread
+  std::atomic<size_t> relay_drops_{0};
+  std::atomic<size_t> relay_calls_{0};
+  std::atomic<size_t> resyncs_{0};
+  // Written by the recv thread only; atomic for the stats reader.
+  std::atomic<size_t> jitter_depth_{64};
+  std::atomic<size_t> reorder_hist_[kReorderBuckets] = {};
+  std::atomic<size_t> late_packets_{0};
+  std::atomic<size_t> recv_calls_{0};
+  std::atomic<size_t> recv_datagrams_{0};
+  std::atomic<size_t> merge_drops_{0};
+  std::atomic<size_t> path_packets_[2] = {};  // written by the path's lane
+  std::atomic<size_t> path_lost_[2]    = {};
+  std::atomic<int64_t> path_skew_ns_{0};  // written by the merge stage
+  std::atomic<int64_t> path_skew_max_ns_{0};
+  std::atomic<size_t> fec_packets_{0};  // written by the FEC thread
+  std::atomic<size_t> fec_recovered_{0};
+  std::atomic<size_t> fec_unrecoverable_{0};
+  std::atomic<size_t> nack_requested_{0};  // written by the recv thread
+  std::atomic<size_t> rtx_recovered_{0};
+  std::atomic<size_t> rtx_late_{0};
+  std::atomic<size_t> nack_expired_{0};
+  std::atomic<size_t> srtp_auth_failures_{0};  // written by the recv thread
+  std::atomic<size_t> srtp_replays_{0};
+  std::atomic<size_t> worker_wakeups_{0};
+  std::atomic<size_t> worker_spins_{0};
+  std::atomic<size_t> inline_frames_{0};
+  std::atomic<size_t> handoff_frames_{0};
+  std::atomic<size_t> rtc_fallbacks_{0};
+  std::atomic<size_t> shed_frames_{0};
+  std::atomic<size_t> shed_packets_{0};
 
-  // SPSC job queue: producer = recv thread, consumer = worker thread.
+  // SPSC job queue: producer = recv thread, consumer = worker thread. The recv thread
+  // stages jobs at job_tail_local_ and publishes a whole in-order run with one store to
+  // job_tail_; job_head_cache_ is its last read of job_head_, refreshed only when the
+  // queue looks full, so neither index line bounces per packet.
   std::vector<Job> job_queue_;
+  size_t job_tail_local_ = 0;
+  size_t job_head_cache_ = 0;
   alignas(64) std::atomic<size_t> job_head_{0};  // consumer index
+  std::atomic<uint64_t> released_gen_{0};         // worker-written too: shares job_head_'s line
+  std::atomic<size_t> worker_done_{0};            // jobs the worker has finished processing
   alignas(64) std::atomic<size_t> job_tail_{0};  // producer index
   std::mutex worker_mu_;
   std::condition_variable worker_cv_;
+  // kSpinPark / kEventfd: 1 while the worker is (about to be) asleep. The recv thread
+  // wakes it only when set, so a spinning worker costs the producer no syscall.
+  alignas(64) std::atomic<uint32_t> worker_parked_{0};
+  int worker_efd_ = -1;
 };
 
+// The worker loop, instantiated per Handler (Receiver::start). Idle waiting stays out of
+// line in worker_idle(); only the dequeue-and-deliver path is specialised.
+template <class Handler>
+void Receiver::worker_loop(Handler& handler) {
+  size_t spins = 0;  // empty polls since the last job or sleep, flushed to worker_spins_
+  Job jobs[kWorkerBatch];
+  while (running_.load(std::memory_order_acquire)) {
+    if (const size_t n = dequeue_jobs(jobs, kWorkerBatch)) {
+      if (spins) {
+        worker_spins_.fetch_add(spins, std::memory_order_relaxed);
+        spins = 0;
+      }
+      process_jobs(handler, jobs, n);
+      worker_done_.fetch_add(n, std::memory_order_release);
+      continue;
+    }
+    worker_idle(spins);
+  }
+  worker_spins_.fetch_add(spins, std::memory_order_relaxed);
+  // Drain remaining jobs so in-flight slabs are handed to the handler, not leaked.
+  while (const size_t n = dequeue_jobs(jobs, kWorkerBatch)) process_jobs(handler, jobs, n);
+}
+
+template <class Handler>
+void Receiver::process_jobs(Handler& handler, const Job* jobs, size_t n) {
+  // Fan-out first, the whole batch in one go: the send is done (the kernel has its own
+  // copy) before the handler can release a slab.
+  if (relay_) relay_jobs(jobs, n);
+  for (size_t k = 0; k < n; ++k) {
+    // The handler reads the RTP header and the J2K main/sub-header right behind it: pull
+    // the next packet's first two lines in while this one is parsed.
+    if (k + 1 < n) {
+      const uint8_t* next = slab_ptr(jobs[k + 1].slab_idx);
+      __builtin_prefetch(next);
+      __builtin_prefetch(next + 64);
+    }
+    // hdr_len was parsed once in handle_dgram and carried through Slot+Job; no re-parse.
+    // The slab is NOT released here — the handler (frame_handler) owns it via
+    // Packet::slab_idx() and must call release_slab() when done. This is what enables the
+    // chain reader to hold slabs across an entire frame's worth of packets without copy.
+    const Job& j = jobs[k];
+    if (j.hdr_len <= j.len) {
+      handler(Packet(slab_ptr(j.slab_idx), j.len, j.slab_idx, j.seq, j.hdr_len, j.flags));
+    } else {
+      release_slab(j.slab_idx);  // not delivered: recv can recycle it at once
+    }
+  }
+}
+
 }  // namespace rtp
 
 #endif  // RTP_RECEIVER_HPP
@@ -0,0 +1,204 @@
+// Relay fan-out for rtp::Receiver (set_relay): the worker forwards every packet it is about
+// to hand to the handler — in order, after the jitter ring, FEC, retransmission and SRTP
+// have had their turn — to each destination, straight from its slab.
+//
+// A worker batch (up to kWorkerBatch jobs) goes out in one sendmmsg() on an unconnected
+// socket. Runs of consecutive packets of one length (the last may be shorter, as a frame's
+// marker packet is) become a single message per destination whose iovecs point into the
+// slabs, carrying a UDP_SEGMENT control message, so the kernel cuts it back into those
+// datagrams (UDP GSO): one trip down the stack per run instead of per packet. Nothing is
+// copied in user space. The kernel copies the bytes into its own buffers before sendmmsg()
+// returns, so the send is complete by then, and only afterwards do the slabs go on to the
+// handler, which releases them. MSG_ZEROCOPY is not used: at ~1400-byte segments pinning
+// the pages and reaping the completions costs more than the copy, and a slab would have to
+// outlive the handler's release of it.
+//
+// Sends never block (MSG_DONTWAIT): a destination that cannot keep up loses packets
+// (relay_drops) rather than stall the parse. If the path refuses GSO, the relay says so
+// once and sends one datagram per message from then on, still one sendmmsg() per batch.
+#include "rtp_receiver.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace rtp {
+
+namespace {
+
+constexpr size_t kGsoMaxSegments = 64;     // UDP_MAX_SEGMENTS of older kernels
+constexpr size_t kGsoMaxBytes    = 65507;  // largest UDP payload over IPv4
+constexpr int kRelaySndBuf       = 8 * 1024 * 1024;
+
+}  // namespace
+
+struct Receiver::RelayState {
+  // Consecutive packets sent as one message: iov[first, first + count), all `seg` bytes
+  // but possibly the last, which then closes the run.
+  struct Run {
+    size_t first;
+    size_t count;
+    size_t bytes;
+    size_t seg;
+    bool open;
+  };
+  union Control {
+    cmsghdr hdr;
+    char buf[CMSG_SPACE(sizeof(uint16_t))];
+  };
+
+  int fd   = -1;
+  bool gso = true;
+  std::vector<sockaddr_in> dests;
+  // Per batch, reused: one iovec per packet, its runs, a UDP_SEGMENT block per run (the
+  // same for every destination), and the messages, destination-major.
+  std::vector<iovec> iov;
+  std::vector<Run> runs;
+  std::vector<Control> control;
+  std::vector<mmsghdr> msgs;
+};
+
+bool Receiver::open_relay() {
+  relay_        = new RelayState;
+  RelayState& r = *relay_;
+  for (const auto& d : relay_dests_) {
+    sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_port   = htons(d.second);
+    if (::inet_pton(AF_INET, d.first.c_str(), &a.sin_addr) != 1) {
+      std::cerr << "rtp::Receiver: inet_pton(" << d.first << ") failed" << std::endl;
+      close_relay();
+      return false;
+    }
+    r.dests.push_back(a);
+  }
+  r.fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (r.fd < 0) {
+    std::cerr << "rtp::Receiver: relay socket: " << std::strerror(errno) << std::endl;
+    close_relay();
+    return false;
+  }
+  // Headroom for a few batches to every destination; best effort, like SO_RCVBUF.
+  ::setsockopt(r.fd, SOL_SOCKET, SO_SNDBUF, &kRelaySndBuf, sizeof(kRelaySndBuf));
+  r.iov.resize(kWorkerBatch);
+  r.runs.reserve(kWorkerBatch);
+  r.control.resize(kWorkerBatch);
+  r.msgs.resize(kWorkerBatch * r.dests.size());
+  return true;
+}
+
+void Receiver::close_relay() {
+  if (!relay_) return;
+  if (relay_->fd >= 0) ::close(relay_->fd);
+  delete relay_;
+  relay_ = nullptr;
+}
+
+// Sends the packets of one worker batch to every destination. Returns once the kernel has
+// taken (or refused) all of them; the slabs are the handler's again after that.
+void Receiver::relay_jobs(const Job* jobs, size_t n) {
+  RelayState& r = *relay_;
+  size_t count  = 0;
+  r.runs.clear();
+  for (size_t k = 0; k < n; ++k) {
+    const Job& j = jobs[k];
+    if (j.hdr_len > j.len) continue;  // not delivered, so not relayed either
+    uint8_t* data = slab_ptr(j.slab_idx);
+    // handle_dgram stripped any padding from len; the header must stop announcing it.
+    data[0]              = static_cast<uint8_t>(data[0] & ~0x20);
+    r.iov[count]         = {data, j.len};
+    RelayState::Run* run = r.runs.empty() ? nullptr : &r.runs.back();
+    if (r.gso && run && run->open && j.len <= run->seg && run->count < kGsoMaxSegments
+        && run->bytes + j.len <= kGsoMaxBytes) {
+      ++run->count;
+      run->bytes += j.len;
+      run->open = j.len == run->seg;
+    } else {
+      r.runs.push_back({count, 1, j.len, j.len, true});
+    }
+    ++count;
+  }
+  if (r.runs.empty()) return;
+
+  size_t m = 0;
+  for (size_t i = 0; i < r.runs.size(); ++i) {
+    const RelayState::Run& run = r.runs[i];
+    if (run.count < 2) continue;
+    cmsghdr* c         = &r.control[i].hdr;
+    c->cmsg_level      = IPPROTO_UDP;
+    c->cmsg_type       = UDP_SEGMENT;
+    c->cmsg_len        = CMSG_LEN(sizeof(uint16_t));
+    const uint16_t seg = static_cast<uint16_t>(run.seg);
+    std::memcpy(CMSG_DATA(c), &seg, sizeof(seg));
+  }
+  for (sockaddr_in& dest : r.dests) {
+    for (size_t i = 0; i < r.runs.size(); ++i) {
+      msghdr& h        = r.msgs[m++].msg_hdr;
+      h                = msghdr{};
+      h.msg_name       = &dest;
+      h.msg_namelen    = sizeof(dest);
+      h.msg_iov        = &r.iov[r.runs[i].first];
+      h.msg_iovlen     = r.runs[i].count;
+      h.msg_control    = r.runs[i].count > 1 ? r.control[i].buf : nullptr;
+      h.msg_controllen = r.runs[i].count > 1 ? sizeof(r.control[i].buf) : 0;
+    }
+  }
+
+  size_t sent    = 0;
+  size_t dropped = 0;
+  size_t calls   = 0;
+  for (size_t i = 0; i < m;) {
+    const int done = ::sendmmsg(r.fd, &r.msgs[i], static_cast<unsigned>(m - i), MSG_DONTWAIT);
+    ++calls;
+    if (done > 0) {
+      const size_t end = i + static_cast<size_t>(done);
+      for (; i < end; ++i) sent += r.msgs[i].msg_hdr.msg_iovlen;
+      continue;
+    }
+    if (errno == EINTR) continue;
+    msghdr& h = r.msgs[i++].msg_hdr;
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+      // The socket's buffer is shared by every destination: the rest would fail too.
+      dropped += h.msg_iovlen;
+      for (; i < m; ++i) dropped += r.msgs[i].msg_hdr.msg_iovlen;
+      break;
+    }
+    if (h.msg_controllen && (errno == EINVAL || errno == EIO || errno == EOPNOTSUPP)) {
+      // GSO refused (no checksum offload on the route's device, or a segment over its
+      // MTU): send this run datagram by datagram, and stop grouping.
+      if (r.gso) {
+        std::cerr << "rtp::Receiver: relay UDP GSO refused (" << std::strerror(errno)
+                  << "); sending one datagram per message" << std::endl;
+        r.gso = false;
+      }
+      for (size_t s = 0; s < h.msg_iovlen; ++s) {
+        msghdr one         = h;
+        one.msg_iov        = &h.msg_iov[s];
+        one.msg_iovlen     = 1;
+        one.msg_control    = nullptr;
+        one.msg_controllen = 0;
+        ++calls;
+        if (::sendmsg(r.fd, &one, MSG_DONTWAIT) >= 0) {
+          ++sent;
+        } else {
+          ++dropped;
+        }
+      }
+      continue;
+    }
+    dropped += h.msg_iovlen;  // this destination refused the run; go on with the others
+  }
+  relay_packets_.fetch_add(sent, std::memory_order_relaxed);
+  relay_drops_.fetch_add(dropped, std::memory_order_relaxed);
+  relay_calls_.fetch_add(calls, std::memory_order_relaxed);
+}
+
+}  // namespace rtp
@@ -0,0 +1,345 @@
+// SO_REUSEPORT multi-socket receive for rtp::Receiver (set_recv_sockets(n > 1)).
+//
+// One UDP socket caps ingest at what a single recv thread and a single socket queue can
+// drain. Here n sockets join one SO_REUSEPORT group on the same address, and a classic
+// BPF program attached to the group picks the socket per datagram from the RTP sequence
+// number (seq % n). The kernel's default group hash is over the 4-tuple, which is
+// constant for an RTP flow and would put every packet on one socket.
+//
+// Each socket is a "lane": its own thread receives with recvmmsg() straight into staged
+// slabs from a private partition of the slab pool (so lanes never contend on the pool
+// cursor), and publishes {slab, len, seq} descriptors on a per-lane SPSC queue. The
+// recv thread becomes the merge stage: it repeatedly takes the lane head closest to the
+// next expected sequence number and feeds it to handle_dgram, so the jitter ring, the
+// job queue and the worker see exactly the single-socket input. Each socket queue is
+// FIFO, so every lane's descriptors are already in order; the merge only has to
+// interleave them. When the expected packet is not at any head and some lane is empty,
+// the merge holds off briefly — that lane's thread may simply not have run yet — before
+// treating it as a hole.
+//
+// The same lanes carry SMPTE 2022-7 dual-path receive (set_redundant_path): two plain
+// sockets, one per network, each receiving the whole stream. The merge stage's
+// nearest-sequence-first pick interleaves the two copies; the jitter ring keeps the
+// first copy of each sequence number and drops the second as a duplicate. The lanes also
+// count each path's own sequence gaps, and the merge measures how far apart the two copies
+// of a packet arrive.
+#include "rtp_receiver.hpp"
+
+#include <linux/filter.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "rtp_wire.hpp"
+
+namespace rtp {
+
+namespace {
+
+constexpr size_t kLaneQueueSize = 4096;  // per lane; ~50 ms of 4K@60 at 1 lane's share
+// How long the merge waits for an empty lane before taking a later sequence number from
+// another lane. Packets are ~13 µs apart at 4K@60; a lane this far behind has lost one.
+constexpr auto kMergeHoldoff = std::chrono::microseconds(100);
+// Empty polls before the merge thread sleeps (kMergeSleep) between polls.
+constexpr unsigned kMergeSpin = 1024;
+constexpr auto kMergeSleep    = std::chrono::microseconds(50);
+// Dual path: recent first arrivals kept for the skew measurement, by sequence number. At
+// 4K@60 this is ~50 ms, well past any differential the jitter ring can absorb.
+constexpr size_t kSkewWindow = 4096;
+constexpr int kSkewSmoothing = 16;  // path_skew_ns_ moves 1/16 of the way per packet pair
+
+}  // namespace
+
+struct Receiver::Lane {
+  struct Dgram {
+    size_t slab;
+    size_t len;
+    uint16_t seq;
+    int64_t arrival_ns;  // dual path only
+  };
+
+  int fd = -1;
+  std::thread thread;
+  size_t index = 0;  // lane / path number
+  // Dual path: this path's next expected sequence number, for path_lost_.
+  bool have_seq     = false;
+  uint16_t next_seq = 0;
+  // Slab partition [slab_base, slab_base + slab_count), scanned from slab_cursor.
+  size_t slab_base   = 0;
+  size_t slab_count  = 0;
+  size_t slab_cursor = 0;
+  size_t stage_run   = 1;  // this lane's Receiver::stage_run_
+  std::vector<Dgram> queue;
+  alignas(64) std::atomic<size_t> head{0};  // consumer (merge) index
+  alignas(64) std::atomic<size_t> tail{0};  // producer (lane) index
+
+  size_t acquire(Receiver& rx, size_t run) { return rx.acquire_in(slab_base, slab_count, slab_cursor, run); }
+};
+
+bool Receiver::open_lanes(const sockaddr_in& addr, const sockaddr_in* redundant) {
+  const size_t n = redundant ? 2 : recv_sockets_;
+  lanes_         = new Lane[n];
+  lane_count_    = n;
+  for (size_t i = 0; i < n; ++i) {
+    Lane& lane      = lanes_[i];
+    lane.index      = i;
+    lane.slab_base  = i * slab_count_ / n;
+    lane.slab_count = (i + 1) * slab_count_ / n - lane.slab_base;
+    lane.queue.assign(kLaneQueueSize, Lane::Dgram{});
+    lane.fd = redundant ? open_udp_socket(i ? *redundant : addr, false) : open_udp_socket(addr, true);
+    if (lane.fd < 0) {
+      close_lanes();
+      return false;
+    }
+  }
+  if (redundant) return true;  // each path's socket takes the whole stream
+
+  // A = seq (UDP payload bytes 2..3: the program sees the skb from the UDP payload);
+  // return A % n as the socket index within the group, in bind order.
+  sock_filter code[] = {
+      {BPF_LD | BPF_H | BPF_ABS, 0, 0, 2},
+      {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(n)},
+      {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  sock_fprog prog{static_cast<unsigned short>(sizeof(code) / sizeof(code[0])), code};
+  if (::setsockopt(lanes_[0].fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) < 0) {
+    std::cerr << "rtp::Receiver: SO_ATTACH_REUSEPORT_CBPF failed: " << std::strerror(errno) << std::endl;
+    close_lanes();
+    return false;
+  }
+  return true;
+}
+
+void Receiver::start_lanes() {
+  for (size_t i = 0; i < lane_count_; ++i) {
+    Lane& lane  = lanes_[i];
+    lane.thread = std::thread([this, &lane] { lane_loop(lane); });
+    pin_thread(lane.thread, i < lane_cpus_.size() ? lane_cpus_[i] : -1, "lane");
+  }
+}
+
+void Receiver::stop_lanes() {
+  if (!lanes_) return;
+  for (size_t i = 0; i < lane_count_; ++i) {
+    if (lanes_[i].fd >= 0) ::shutdown(lanes_[i].fd, SHUT_RD);
+  }
+  for (size_t i = 0; i < lane_count_; ++i) {
+    if (lanes_[i].thread.joinable()) lanes_[i].thread.join();
+  }
+}
+
+void Receiver::close_lanes() {
+  if (!lanes_) return;
+  for (size_t i = 0; i < lane_count_; ++i) {
+    if (lanes_[i].fd >= 0) ::close(lanes_[i].fd);
+  }
+  delete[] lanes_;
+  lanes_      = nullptr;
+  lane_count_ = 0;
+}
+
+// Dual path, lane thread: counts a datagram of this path and its own loss. A forward
+// skip counts the sequence numbers skipped, a packet this path reordered gives one back;
+// a jump the jitter ring would resync on is a sender restart, not loss.
+void Receiver::note_path_seq(Lane& lane, uint16_t seq) {
+  std::atomic<size_t>& packets = path_packets_[lane.index];
+  std::atomic<size_t>& lost    = path_lost_[lane.index];
+  packets.fetch_add(1, std::memory_order_relaxed);
+  if (lane.have_seq) {
+    const int16_t skip = static_cast<int16_t>(seq - lane.next_seq);
+    if (skip < 0 && skip > -resync_jump_) {
+      if (lost.load(std::memory_order_relaxed)) lost.fetch_sub(1, std::memory_order_relaxed);
+      return;
+    }
+    if (skip > 0 && skip < resync_jump_)
+      lost.fetch_add(static_cast<size_t>(skip), std::memory_order_relaxed);
+  }
+  lane.have_seq = true;
+  lane.next_seq = static_cast<uint16_t>(seq + 1);
+}
+
+void Receiver::lane_loop(Lane& lane) {
+  // Same staging as recv_loop_batched, but a received datagram is handed to the merge
+  // stage instead of handle_dgram. With the partition exhausted the datagram lands in
+  // its message's scratch slot (so its sequence number still reads right for the path
+  // counters) and is dropped here, counted busy: unlike the single-socket path it cannot
+  // reach the jitter ring, whose force-advance then counts the hole as net loss.
+  const size_t batch   = recv_batch_;
+  const bool dual_path = !redundant_addr_.empty();
+  std::vector<uint8_t> scratch(batch * kSlabBytes);
+  std::vector<uint8_t> spill(batch * spill_bytes_);
+  std::vector<size_t> staged(batch, kNoSlab);
+  std::vector<iovec> iovs(2 * batch);  // [slab or scratch, spill] per message
+  std::vector<mmsghdr> msgs(batch);
+  timespec timeout{};
+  timeout.tv_sec        = recv_batch_timeout_us_ / 1000000;
+  timeout.tv_nsec       = (recv_batch_timeout_us_ % 1000000) * 1000L;
+  const bool fill_batch = batch > 1 && recv_batch_timeout_us_ > 0;
+  for (size_t i = 0; i < batch; ++i) {
+    iovs[2 * i + 1].iov_base = spill.data() + i * spill_bytes_;
+    iovs[2 * i + 1].iov_len  = spill_bytes_;
+  }
+
+  while (running_.load(std::memory_order_acquire)) {
+    for (size_t i = 0; i < batch; ++i) {
+      if (staged[i] == kNoSlab) staged[i] = lane.acquire(*this, lane.stage_run);
+      iovs[2 * i].iov_base = (staged[i] != kNoSlab) ? slab_ptr(staged[i]) : scratch.data() + i * kSlabBytes;
+      iovs[2 * i].iov_len  = slab_capacity(staged[i]);
+
+      msgs[i].msg_hdr            = msghdr{};
+      msgs[i].msg_hdr.msg_iov    = &iovs[2 * i];
+      msgs[i].msg_hdr.msg_iovlen = 2;
+      msgs[i].msg_len            = 0;
+    }
+    int n = ::recvmmsg(lane.fd, msgs.data(), static_cast<unsigned>(batch), fill_batch ? 0 : MSG_WAITFORONE,
+                       fill_batch ? &timeout : nullptr);
+    if (n < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) continue;
+      break;
+    }
+    recv_calls_.fetch_add(1, std::memory_order_relaxed);
+    recv_datagrams_.fetch_add(static_cast<size_t>(n), std::memory_order_relaxed);
+    // Dual path: one clock read per call stamps the batch for the skew measurement.
+    const int64_t arrival = dual_path ? now_ns() : 0;
+
+    // One tail publish per call; the merge sees the whole batch at once.
+    size_t tail       = lane.tail.load(std::memory_order_relaxed);
+    const size_t head = lane.head.load(std::memory_order_acquire);
+    for (int i = 0; i < n; ++i) {
+      if (msgs[i].msg_len < 12) continue;
+      const auto* p      = static_cast<const uint8_t*>(iovs[2 * i].iov_base);
+      const uint16_t seq = rd_u16(p + 2);
+      if (dual_path) note_path_seq(lane, seq);
+      if (staged[i] == kNoSlab) {
+        slot_busy_drops_.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      if (tail - head >= kLaneQueueSize) {
+        merge_drops_.fetch_add(1, std::memory_order_relaxed);  // slab stays staged
+        continue;
+      }
+      // As handle_received: trim a run that fits, join one that spilled into a fresh run.
+      const size_t len = msgs[i].msg_len;
+      const size_t cap = slab_capacity(staged[i]);
+      lane.stage_run   = std::min(slabs_for(len), max_run_);
+      if (len > cap) {
+        const size_t run = lane.acquire(*this, lane.stage_run);
+        if (run == kNoSlab) {
+          slot_busy_drops_.fetch_add(1, std::memory_order_relaxed);
+          continue;
+        }
+        join_spill(run, p, cap, spill.data() + i * spill_bytes_, len);
+        lane.queue[tail++ % kLaneQueueSize] = {run, len, seq, arrival};
+        continue;
+      }
+      trim_run(staged[i], len);
+      lane.queue[tail++ % kLaneQueueSize] = {staged[i], len, seq, arrival};
+      staged[i]                           = kNoSlab;
+    }
+    lane.tail.store(tail, std::memory_order_release);
+  }
+  for (size_t s : staged)
+    if (s != kNoSlab) free_slab(s);
+}
+
+void Receiver::merge_loop() {
+  const size_t n   = lane_count_;
+  bool have_expect = false;
+  uint16_t expect  = 0;  // sequence number after the last one merged
+  unsigned idle    = 0;
+  bool holding     = false;
+  std::chrono::steady_clock::time_point hold_start;
+  // Dual path: the first copy of each recent sequence number, until its twin shows up.
+  struct FirstCopy {
+    int64_t arrival_ns;
+    uint16_t seq;
+    uint8_t path;
+    bool open;
+  };
+  const bool dual_path = !redundant_addr_.empty();
+  std::vector<FirstCopy> first(dual_path ? kSkewWindow : 0, FirstCopy{0, 0, 0, false});
+
+  while (running_.load(std::memory_order_acquire)) {
+    Lane* best     = nullptr;
+    int best_dist  = INT_MAX;
+    bool any_empty = false;
+    for (size_t i = 0; i < n; ++i) {
+      Lane& lane     = lanes_[i];
+      const size_t h = lane.head.load(std::memory_order_relaxed);
+      if (h == lane.tail.load(std::memory_order_acquire)) {
+        any_empty = true;
+        continue;
+      }
+      const Lane::Dgram& d = lane.queue[h % kLaneQueueSize];
+      const int dist       = have_expect ? static_cast<int16_t>(d.seq - expect) : 0;
+      if (dist < best_dist) {
+        best      = &lane;
+        best_dist = dist;
+      }
+    }
+
+    if (!best) {
+      if (++idle < kMergeSpin) {
+        std::this_thread::yield();
+      } else {
+        std::this_thread::sleep_for(kMergeSleep);
+      }
+      continue;
+    }
+    idle = 0;
+
+    if (best_dist > 0 && any_empty) {
+      // The expected packet may still be on its way through an empty lane.
+      const auto now = std::chrono::steady_clock::now();
+      if (!holding) {
+        holding    = true;
+        hold_start = now;
+        continue;
+      }
+      if (now - hold_start < kMergeHoldoff) {
+        std::this_thread::yield();
+        continue;
+      }
+    }
+    holding = false;
+
+    const size_t h      = best->head.load(std::memory_order_relaxed);
+    const Lane::Dgram d = best->queue[h % kLaneQueueSize];
+    best->head.store(h + 1, std::memory_order_release);
+    if (best_dist >= 0) {
+      expect      = static_cast<uint16_t>(d.seq + 1);
+      have_expect = true;
+    }
+    if (dual_path) {
+      // Lanes stamp whole batches, so the skew is exact to within one receive call.
+      const uint8_t path = static_cast<uint8_t>(best - lanes_);
+      FirstCopy& f       = first[d.seq % kSkewWindow];
+      if (f.open && f.seq == d.seq && f.path != path) {
+        const int64_t skew = path ? d.arrival_ns - f.arrival_ns : f.arrival_ns - d.arrival_ns;
+        const int64_t avg  = path_skew_ns_.load(std::memory_order_relaxed);
+        path_skew_ns_.store(avg + (skew - avg) / kSkewSmoothing, std::memory_order_relaxed);
+        if (std::abs(skew) > std::abs(path_skew_max_ns_.load(std::memory_order_relaxed)))
+          path_skew_max_ns_.store(skew, std::memory_order_relaxed);
+        f.open = false;
+      } else {
+        f = FirstCopy{d.arrival_ns, d.seq, path, true};
+      }
+    }
+    if (!handle_dgram(slab_ptr(d.slab), d.len, d.slab)) free_slab(d.slab);
+  }
+  // Descriptors still queued own their slabs.
+  for (size_t i = 0; i < n; ++i) {
+    Lane& lane = lanes_[i];
+    for (size_t h = lane.head.load(); h != lane.tail.load(); ++h) free_slab(lane.queue[h % kLaneQueueSize].slab);
+  }
+}
+
+}  // namespace rtp
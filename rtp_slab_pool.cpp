@@ -0,0 +1,128 @@
+// Slab pool memory for rtp::Receiver (set_slab_memory).
+//
+// The pool used to be a zero-filled std::vector: the constructor wrote every byte of it
+// (151 MB before slabs shrank to 1536 bytes) before the first packet could be received,
+// which is most of the startup time on an A53, and it sat on 4 KB pages, so the worker's
+// walk over 12+ frames of history took a dTLB miss every few packets. Here it is an
+// anonymous private mapping: the kernel commits and zeroes a page on first touch, so
+// start() returns at once, and on 2 MB pages the default 25 MB pool is 12 TLB entries
+// instead of 6144.
+//
+// The prefault thread populates the mapping front first — recv stages slabs from the
+// front — so steady state does not pay the faults either. It must not write the pool:
+// the kernel may already be receiving into those slabs. MADV_POPULATE_WRITE (Linux 5.14)
+// faults pages in without touching their contents; on older kernels an atomic add of
+// zero per page does the same.
+#include "rtp_receiver.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace rtp {
+
+namespace {
+
+constexpr size_t kHugePage  = size_t{2} << 20;  // PMD size on x86-64 and 4 KB-granule arm64
+constexpr size_t kTouchStep = 4096;             // smallest page size, so no page is skipped
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+}  // namespace
+
+bool Receiver::map_slabs(size_t bytes) {
+  unmap_slabs();
+  const size_t huge_len = (bytes + kHugePage - 1) / kHugePage * kHugePage;
+  slab_map_asked_       = slab_pages_;
+  slab_map_locked_      = slab_lock_;
+  slab_map_pages_       = slab_pages_;
+
+  if (slab_pages_ == SlabPages::kHugeTlb) {
+    // Without MAP_NORESERVE the pages are reserved here, so a short pool fails now rather
+    // than as a SIGBUS on first touch.
+    void* map =
+        ::mmap(nullptr, huge_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (map != MAP_FAILED) {
+      slab_map_       = map;
+      slab_map_bytes_ = huge_len;
+      slab_           = static_cast<uint8_t*>(map);
+    } else {
+      std::cerr << "rtp::Receiver: mmap(MAP_HUGETLB, " << huge_len / kHugePage << " x 2 MB) failed: "
+                << std::strerror(errno) << " (vm.nr_hugepages too low?); using transparent huge pages"
+                << std::endl;
+      slab_map_pages_ = SlabPages::kThp;
+    }
+  }
+
+  if (!slab_map_) {
+    // THP only backs 2 MB-aligned extents: map one huge page more and align the pool.
+    const bool thp   = slab_map_pages_ == SlabPages::kThp;
+    const size_t len = thp ? huge_len + kHugePage : bytes;
+    void* map        = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+      std::cerr << "rtp::Receiver: mmap(slab pool, " << len << " bytes) failed: " << std::strerror(errno)
+                << std::endl;
+      return false;
+    }
+    slab_map_       = map;
+    slab_map_bytes_ = len;
+    auto addr       = reinterpret_cast<uintptr_t>(map);
+    if (thp) {
+      addr = (addr + kHugePage - 1) & ~(kHugePage - 1);
+      if (::madvise(reinterpret_cast<void*>(addr), huge_len, MADV_HUGEPAGE) != 0) {
+        std::cerr << "rtp::Receiver: madvise(MADV_HUGEPAGE) failed: " << std::strerror(errno)
+                  << "; slab pool on 4 KB pages" << std::endl;
+      }
+    } else {
+      ::madvise(map, len, MADV_NOHUGEPAGE);  // THP "always" would promote it regardless
+    }
+    slab_ = reinterpret_cast<uint8_t*>(addr);
+  }
+
+  // MLOCK_ONFAULT: lock pages as they are faulted in rather than populating the whole
+  // pool here, which would put the startup cost back.
+  if (slab_lock_ && ::mlock2(slab_, bytes, MLOCK_ONFAULT) != 0) {
+    std::cerr << "rtp::Receiver: mlock2(slab pool, " << bytes << " bytes) failed: " << std::strerror(errno)
+              << " (raise RLIMIT_MEMLOCK); slab pool unlocked" << std::endl;
+  }
+  return true;
+}
+
+void Receiver::unmap_slabs() {
+  if (slab_map_) ::munmap(slab_map_, slab_map_bytes_);
+  slab_map_       = nullptr;
+  slab_map_bytes_ = 0;
+  slab_           = nullptr;
+}
+
+void Receiver::prefault_slabs() {
+#ifdef SCHED_IDLE
+  // Only take otherwise idle CPU time: if recv or the worker needs the core, they fault
+  // their own pages in as before.
+  sched_param sp{};
+  ::pthread_setschedparam(::pthread_self(), SCHED_IDLE, &sp);
+#endif
+  slab_prefaulted_.store(0, std::memory_order_relaxed);
+  // hugetlbfs ranges must cover whole huge pages.
+  const size_t bytes = slab_map_pages_ == SlabPages::kHugeTlb ? slab_map_bytes_ : slab_count_ * kSlabBytes;
+  bool populate      = true;
+  // One huge page per step, so stop() is noticed within a few milliseconds.
+  for (size_t off = 0; off < bytes && running_.load(std::memory_order_relaxed); off += kHugePage) {
+    const size_t len = std::min(kHugePage, bytes - off);
+    if (populate && ::madvise(slab_ + off, len, MADV_POPULATE_WRITE) != 0) populate = false;
+    if (!populate) {
+      for (size_t p = 0; p < len; p += kTouchStep) __atomic_fetch_add(slab_ + off + p, 0, __ATOMIC_RELAXED);
+    }
+    slab_prefaulted_.fetch_add(len, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace rtp
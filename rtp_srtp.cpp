@@ -0,0 +1,126 @@
+// SRTP receive for rtp::Receiver (set_srtp): each packet is authenticated and decrypted in
+// place in its slab on the recv thread, before it touches any sequence state — a forged or
+// corrupt packet is dropped as if it had never arrived (the ring counts the hole like any
+// other loss), so it can neither fill a slot nor move the window.
+//
+// Replay protection is SRTP's own (RFC 3711 §3.3.2), not the jitter ring's: the ring takes
+// a pair of old packets far enough behind for a sender restart and resyncs to them. Per
+// stream the receiver keeps the highest index authenticated and a bitmap of the
+// kReplayWindow indexes below it; an index already in the bitmap, or older than the
+// bitmap reaches, is dropped before it is authenticated (srtp_replays) and never reaches
+// the ring. The window covers twice the deepest jitter ring, so an authentic packet that
+// is merely late still gets to the ring and is counted late there.
+//
+// The 48-bit packet index is the rollover counter (ROC) the receiver keeps per stream
+// times 2^16 plus the sequence number, with the ROC guessed per packet as in RFC 3711
+// Appendix A from the highest sequence number authenticated so far. The state only moves
+// on a packet that authenticates under the guess, so garbage cannot desynchronize it. A
+// new SSRC starts a new stream at ROC 0.
+#include "rtp_receiver.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+#include "rtp_srtp.hpp"
+#include "rtp_wire.hpp"
+
+namespace rtp {
+
+namespace {
+// Packet indexes behind the highest authenticated one that the replay bitmap tracks.
+constexpr uint64_t kReplayWindow = 4096;
+}  // namespace
+
+struct Receiver::SrtpState {
+  srtp::Context ctx;
+  uint32_t ssrc = 0;
+  uint32_t roc  = 0;
+  uint16_t s_l  = 0;  // highest sequence number authenticated in this ROC period
+  bool have     = false;
+  // Replay window: the highest packet index authenticated, and bit i % kReplayWindow set
+  // for each index i in (top - kReplayWindow, top] authenticated so far.
+  uint64_t top                     = 0;
+  uint64_t seen[kReplayWindow / 64] = {};
+
+  bool seen_bit(uint64_t i) const { return (seen[i % kReplayWindow / 64] >> (i % 64)) & 1; }
+  bool replayed(uint64_t i) const { return i + kReplayWindow <= top || (i <= top && seen_bit(i)); }
+  void accept(uint64_t i) {
+    if (i > top) {
+      if (i - top >= kReplayWindow) {
+        std::fill(std::begin(seen), std::end(seen), 0);
+      } else {
+        for (uint64_t k = top + 1; k <= i; ++k) seen[k % kReplayWindow / 64] &= ~(uint64_t{1} << (k % 64));
+      }
+      top = i;
+    }
+    seen[i % kReplayWindow / 64] |= uint64_t{1} << (i % 64);
+  }
+};
+
+bool Receiver::open_srtp() {
+  const size_t salt = srtp_suite_ == srtp::Suite::kAeadAes128Gcm ? 12 : 14;
+  srtp_             = new SrtpState;
+  if (srtp_key_.size() != 16 + salt
+      || !srtp_->ctx.set_key(srtp_suite_, srtp_key_.data(), 16, srtp_key_.data() + 16, salt)) {
+    std::cerr << "rtp::Receiver: SRTP needs a 16-byte master key and a " << salt << "-byte master salt"
+              << std::endl;
+    close_srtp();
+    return false;
+  }
+  return true;
+}
+
+void Receiver::close_srtp() {
+  delete srtp_;
+  srtp_ = nullptr;
+}
+
+// Authenticates and decrypts the SRTP packet in `data` in place; `len` becomes the RTP
+// length. False (counted) if it is a replay or does not authenticate.
+bool Receiver::srtp_unprotect(uint8_t* data, size_t& len) {
+  SrtpState& s = *srtp_;
+  // Header length: the part left in the clear.
+  size_t hdr = 12 + 4u * (data[0] & 0x0F);
+  if (len >= hdr + 4 && (data[0] & 0x10)) hdr += 4u + 4u * rd_u16(data + hdr + 2);
+  const size_t tag    = s.ctx.overhead();
+  const uint16_t seq  = rd_u16(data + 2);
+  const uint32_t ssrc = rd_u32(data + 8);
+  const bool same     = s.have && ssrc == s.ssrc;
+  // RFC 3711 Appendix A: the ROC that puts seq closest to s_l.
+  uint32_t v = same ? s.roc : 0;
+  if (same) {
+    if (s.s_l < 32768) {
+      if (seq - s.s_l > 32768 && s.roc > 0) v = s.roc - 1;
+    } else if (s.s_l - 32768 > seq) {
+      v = s.roc + 1;
+    }
+  }
+  const uint64_t index = uint64_t{v} << 16 | seq;
+  if (same && s.replayed(index)) {
+    srtp_replays_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  if (len < hdr + tag || !s.ctx.unprotect(data, len, hdr, index)) {
+    srtp_auth_failures_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  len -= tag;
+  if (!same) {
+    s.ssrc = ssrc;
+    s.roc  = 0;
+    s.s_l  = seq;
+    s.have = true;
+    s.top  = index;
+    std::fill(std::begin(s.seen), std::end(s.seen), 0);
+  } else if (v > s.roc) {
+    s.roc = v;
+    s.s_l = seq;
+  } else if (v == s.roc && seq > s.s_l) {
+    s.s_l = seq;
+  }
+  s.accept(index);
+  return true;
+}
+
+}  // namespace rtp
@@ -0,0 +1,99 @@
+// SRTP (RFC 3711) packet protection for rtp::Receiver: AES-CM-128 with HMAC-SHA1-80, and
+// AEAD_AES_128_GCM (RFC 7714).
+//
+// The primitives run on the CPU's crypto extensions when it has them — AES-NI, PCLMULQDQ
+// and SHA-NI on x86-64; the ARMv8 Cryptography Extension (AESE/AESMC, PMULL, SHA1C/P/M;
+// present on the Cortex-A53 of the Zynq UltraScale+) on AArch64 — with a portable
+// fallback otherwise (rtp_srtp_crypto.cpp).
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rtp {
+namespace srtp {
+
+enum class Suite { kAesCm128HmacSha1_80, kAeadAes128Gcm };
+
+// Crypto extensions found at run time.
+struct Cpu {
+  bool aes   = false;
+  bool clmul = false;  // carry-less multiply, for GCM's GHASH
+  bool sha1  = false;
+};
+Cpu detect();
+// Use the extensions detect() finds (the default) or the portable code throughout, e.g. to
+// compare the two. Not thread-safe: call before any context is in use.
+void use_extensions(bool on);
+// What the primitives currently run on, e.g. "AES-NI, PCLMUL, SHA-NI" or "portable".
+const char* backend();
+
+class Aes128 {
+ public:
+  void set_key(const uint8_t key[16]);
+  void encrypt_block(const uint8_t in[16], uint8_t out[16]) const;
+  // XORs `len` bytes of `data` with the keystream of the counter blocks from `ctr` on,
+  // the low 32 bits incremented (big-endian) per block: AES-CM's and GCM's CTR mode.
+  void ctr_xor(const uint8_t ctr[16], uint8_t* data, size_t len) const;
+
+ private:
+  alignas(16) uint8_t rk_[11 * 16];
+};
+
+class HmacSha1 {
+ public:
+  void set_key(const uint8_t* key, size_t len);
+  // HMAC-SHA1 over a || b.
+  void mac(const uint8_t* a, size_t a_len, const uint8_t* b, size_t b_len, uint8_t out[20]) const;
+
+ private:
+  uint32_t inner_[5];  // SHA-1 state after the key block XOR ipad / opad
+  uint32_t outer_[5];
+};
+
+class Gcm128 {
+ public:
+  void set_key(const uint8_t key[16]);
+  // Encrypts `data` in place and writes the 16-byte tag over `aad` and the ciphertext.
+  void seal(const uint8_t iv[12], const uint8_t* aad, size_t aad_len, uint8_t* data, size_t len,
+            uint8_t tag[16]) const;
+  // Checks `tag` and, only if it matches, decrypts `data` in place.
+  bool open(const uint8_t iv[12], const uint8_t* aad, size_t aad_len, uint8_t* data, size_t len,
+            const uint8_t tag[16]) const;
+
+ private:
+  void tag_of(const uint8_t iv[12], const uint8_t* aad, size_t aad_len, const uint8_t* data, size_t len,
+              uint8_t tag[16]) const;
+  Aes128 aes_;
+  alignas(16) uint8_t h_[4 * 16];  // H, H^2, H^3, H^4
+};
+
+// Session keys of one SRTP stream, derived from the master key and salt (RFC 3711 §4.3,
+// key derivation rate 0; no MKI).
+class Context {
+ public:
+  // Master key 16 bytes; master salt 14 (AES-CM) or 12 (GCM) bytes. False on other lengths.
+  bool set_key(Suite suite, const uint8_t* key, size_t key_len, const uint8_t* salt, size_t salt_len);
+  // Bytes the protection adds after the payload: the authentication tag.
+  size_t overhead() const { return suite_ == Suite::kAeadAes128Gcm ? 16 : 10; }
+  // Authenticates the `len`-byte SRTP packet (RTP header `hdr` bytes, clear) as packet
+  // index `index` (ROC << 16 | SEQ) and, if it checks out, decrypts its payload in place.
+  // The packet is then len - overhead() bytes of RTP. False if it is forged, corrupt or
+  // keyed for another index; it is left as it was.
+  bool unprotect(uint8_t* pkt, size_t len, size_t hdr, uint64_t index) const;
+  // The sender's side (tests and benchmarks): encrypts the payload in place and appends
+  // the tag; `pkt` needs overhead() bytes of room. Returns the SRTP length.
+  size_t protect(uint8_t* pkt, size_t len, size_t hdr, uint64_t index) const;
+
+ private:
+  void cm_iv(const uint8_t* pkt, uint64_t index, uint8_t iv[16]) const;
+  void gcm_iv(const uint8_t* pkt, uint64_t index, uint8_t iv[12]) const;
+  Suite suite_ = Suite::kAesCm128HmacSha1_80;
+  Aes128 aes_;  // AES-CM session key
+  HmacSha1 hmac_;
+  Gcm128 gcm_;
+  uint8_t salt_[14] = {};
+};
+
+}  // namespace srtp
+}  // namespace rtp
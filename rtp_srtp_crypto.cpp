@@ -0,0 +1,812 @@
+// SRTP primitives (rtp_srtp.hpp): AES-128 block and CTR, SHA-1 / HMAC, GCM, and the SRTP
+// key derivation and packet transforms built on them.
+//
+// Each primitive that dominates the cost per byte has a portable version and one per
+// instruction set: the AES rounds (AES-NI / AESE+AESMC, four blocks in flight to cover
+// the instruction latency), the SHA-1 compression (SHA-NI / SHA1C+SHA1P+SHA1M) and the
+// GHASH multiply (PCLMULQDQ / PMULL). They are compiled with per-function target
+// attributes, so the build needs no -march flags, and picked at run time from what the
+// CPU reports. Key expansion, padding and the HMAC/GCM framing are shared.
+#include "rtp_srtp.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define RTP_SRTP_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#define RTP_SRTP_ARM 1
+#endif
+
+namespace rtp {
+namespace srtp {
+
+namespace {
+
+inline uint32_t be32(const uint8_t* p) {
+  return (uint32_t{p[0]} << 24) | (uint32_t{p[1]} << 16) | (uint32_t{p[2]} << 8) | uint32_t{p[3]};
+}
+inline void put_be32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (24 - 8 * i));
+}
+inline uint64_t be64(const uint8_t* p) { return (uint64_t{be32(p)} << 32) | be32(p + 4); }
+inline void put_be64(uint8_t* p, uint64_t v) {
+  put_be32(p, static_cast<uint32_t>(v >> 32));
+  put_be32(p + 4, static_cast<uint32_t>(v));
+}
+inline uint32_t rotl(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+inline uint8_t xtime(uint8_t x) { return static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1B : 0)); }
+
+// ---- portable -------------------------------------------------------------------------
+
+struct Sbox {
+  uint8_t s[256];
+  Sbox() {
+    // Walks the multiplicative group by 3 and 1/3 together: q = p^-1, then the affine map.
+    uint8_t p = 1, q = 1;
+    do {
+      p = static_cast<uint8_t>(p ^ (p << 1) ^ ((p & 0x80) ? 0x1B : 0));
+      q = static_cast<uint8_t>(q ^ (q << 1));
+      q = static_cast<uint8_t>(q ^ (q << 2));
+      q = static_cast<uint8_t>(q ^ (q << 4));
+      if (q & 0x80) q ^= 0x09;
+      auto rot = [](uint8_t x, int n) { return static_cast<uint8_t>((x << n) | (x >> (8 - n))); };
+      s[p]     = static_cast<uint8_t>(q ^ rot(q, 1) ^ rot(q, 2) ^ rot(q, 3) ^ rot(q, 4) ^ 0x63);
+    } while (p != 1);
+    s[0] = 0x63;
+  }
+};
+const Sbox& sbox() {
+  static const Sbox box;
+  return box;
+}
+
+void aes_block_portable(const uint8_t* rk, const uint8_t* in, uint8_t* out) {
+  const uint8_t* S = sbox().s;
+  uint8_t s[16], t[16];
+  for (int i = 0; i < 16; ++i) s[i] = in[i] ^ rk[i];
+  for (int round = 1; round <= 10; ++round) {
+    // SubBytes + ShiftRows (state column-major: byte c * 4 + r).
+    for (int c = 0; c < 4; ++c)
+      for (int r = 0; r < 4; ++r) t[c * 4 + r] = S[s[((c + r) & 3) * 4 + r]];
+    if (round < 10) {
+      for (int c = 0; c < 4; ++c) {
+        uint8_t* a     = t + c * 4;
+        const uint8_t x = a[0] ^ a[1] ^ a[2] ^ a[3];
+        const uint8_t a0 = a[0];
+        for (int r = 0; r < 4; ++r) {
+          const uint8_t next = r < 3 ? a[r + 1] : a0;
+          a[r]               = static_cast<uint8_t>(a[r] ^ x ^ xtime(static_cast<uint8_t>(a[r] ^ next)));
+        }
+      }
+    }
+    for (int i = 0; i < 16; ++i) s[i] = t[i] ^ rk[round * 16 + i];
+  }
+  std::memcpy(out, s, 16);
+}
+
+void ctr_xor_portable(const uint8_t* rk, const uint8_t* ctr, uint8_t* data, size_t len) {
+  uint8_t block[16], ks[16];
+  std::memcpy(block, ctr, 16);
+  uint32_t c = be32(ctr + 12);
+  while (len) {
+    put_be32(block + 12, c++);
+    aes_block_portable(rk, block, ks);
+    const size_t n = len < 16 ? len : 16;
+    for (size_t i = 0; i < n; ++i) data[i] ^= ks[i];
+    data += n;
+    len -= n;
+  }
+}
+
+void sha1_portable(uint32_t* h, const uint8_t* data, size_t blocks) {
+  for (; blocks; --blocks, data += 64) {
+    uint32_t w[80];
+    for (int t = 0; t < 16; ++t) w[t] = be32(data + 4 * t);
+    for (int t = 16; t < 80; ++t) w[t] = rotl(w[t - 3] ^ w[t - 8] ^ w[t - 14] ^ w[t - 16], 1);
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int t = 0; t < 80; ++t) {
+      uint32_t f, k;
+      if (t < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      } else if (t < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      } else if (t < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+      const uint32_t tmp = rotl(a, 5) + f + e + k + w[t];
+      e                  = d;
+      d                  = c;
+      c                  = rotl(b, 30);
+      b                  = a;
+      a                  = tmp;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+}
+
+// GHASH: y = (y ^ block) * H for each 16-byte block of `data` (the last zero-padded), in
+// GCM's bit-reflected GF(2^128). `h` is H, H^2, H^3, H^4; this version uses H only.
+void ghash_portable(const uint8_t* h, uint8_t* y, const uint8_t* data, size_t len) {
+  const uint64_t h_hi = be64(h), h_lo = be64(h + 8);
+  uint64_t y_hi = be64(y), y_lo = be64(y + 8);
+  while (len) {
+    uint8_t block[16] = {};
+    const size_t n    = len < 16 ? len : 16;
+    std::memcpy(block, data, n);
+    y_hi ^= be64(block);
+    y_lo ^= be64(block + 8);
+    uint64_t z_hi = 0, z_lo = 0, v_hi = h_hi, v_lo = h_lo;
+    for (int i = 0; i < 128; ++i) {
+      const uint64_t bit = (i < 64 ? y_hi >> (63 - i) : y_lo >> (127 - i)) & 1;
+      z_hi ^= v_hi & (0 - bit);
+      z_lo ^= v_lo & (0 - bit);
+      const uint64_t carry = v_lo & 1;
+      v_lo                 = (v_lo >> 1) | (v_hi << 63);
+      v_hi                 = (v_hi >> 1) ^ (0xE100000000000000ull & (0 - carry));
+    }
+    y_hi = z_hi;
+    y_lo = z_lo;
+    data += n;
+    len -= n;
+  }
+  put_be64(y, y_hi);
+  put_be64(y + 8, y_lo);
+}
+
+// ---- x86-64: AES-NI, PCLMULQDQ, SHA-NI ------------------------------------------------
+
+#if RTP_SRTP_X86
+__attribute__((target("aes,sse4.1"))) void aes_block_x86(const uint8_t* rk, const uint8_t* in,
+                                                          uint8_t* out) {
+  __m128i b = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)),
+                            _mm_load_si128(reinterpret_cast<const __m128i*>(rk)));
+  for (int r = 1; r < 10; ++r)
+    b = _mm_aesenc_si128(b, _mm_load_si128(reinterpret_cast<const __m128i*>(rk + 16 * r)));
+  b = _mm_aesenclast_si128(b, _mm_load_si128(reinterpret_cast<const __m128i*>(rk + 160)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), b);
+}
+
+__attribute__((target("sse4.1"))) inline __m128i counter_x86(__m128i base, uint32_t n) {
+  return _mm_insert_epi32(base, static_cast<int>(__builtin_bswap32(n)), 3);
+}
+
+__attribute__((target("aes,sse4.1"))) void ctr_xor_x86(const uint8_t* rk, const uint8_t* ctr, uint8_t* data,
+                                                        size_t len) {
+  __m128i k[11];
+  for (int r = 0; r < 11; ++r) k[r] = _mm_load_si128(reinterpret_cast<const __m128i*>(rk + 16 * r));
+  const __m128i base = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctr));
+  uint32_t c         = be32(ctr + 12);
+  for (; len >= 64; len -= 64, data += 64, c += 4) {
+    __m128i b0 = _mm_xor_si128(counter_x86(base, c), k[0]);
+    __m128i b1 = _mm_xor_si128(counter_x86(base, c + 1), k[0]);
+    __m128i b2 = _mm_xor_si128(counter_x86(base, c + 2), k[0]);
+    __m128i b3 = _mm_xor_si128(counter_x86(base, c + 3), k[0]);
+    for (int r = 1; r < 10; ++r) {
+      b0 = _mm_aesenc_si128(b0, k[r]);
+      b1 = _mm_aesenc_si128(b1, k[r]);
+      b2 = _mm_aesenc_si128(b2, k[r]);
+      b3 = _mm_aesenc_si128(b3, k[r]);
+    }
+    auto* d = reinterpret_cast<__m128i*>(data);
+    _mm_storeu_si128(d, _mm_xor_si128(_mm_loadu_si128(d), _mm_aesenclast_si128(b0, k[10])));
+    _mm_storeu_si128(d + 1, _mm_xor_si128(_mm_loadu_si128(d + 1), _mm_aesenclast_si128(b1, k[10])));
+    _mm_storeu_si128(d + 2, _mm_xor_si128(_mm_loadu_si128(d + 2), _mm_aesenclast_si128(b2, k[10])));
+    _mm_storeu_si128(d + 3, _mm_xor_si128(_mm_loadu_si128(d + 3), _mm_aesenclast_si128(b3, k[10])));
+  }
+  for (; len; ++c) {
+    __m128i b = _mm_xor_si128(counter_x86(base, c), k[0]);
+    for (int r = 1; r < 10; ++r) b = _mm_aesenc_si128(b, k[r]);
+    alignas(16) uint8_t ks[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(ks), _mm_aesenclast_si128(b, k[10]));
+    const size_t n = len < 16 ? len : 16;
+    for (size_t i = 0; i < n; ++i) data[i] ^= ks[i];
+    data += n;
+    len -= n;
+  }
+}
+
+// Intel's carry-less multiply for GCM on byte-reflected operands, split in two so that
+// several products can share one reduction: the 256-bit product accumulated into
+// (lo, hi), then shifted left one bit and reduced modulo x^128 + x^7 + x^2 + x + 1.
+__attribute__((target("pclmul,ssse3"))) inline void clmul_acc_x86(__m128i a, __m128i b, __m128i& lo,
+                                                                   __m128i& hi) {
+  const __m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+  lo = _mm_xor_si128(lo, _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x00), _mm_slli_si128(mid, 8)));
+  hi = _mm_xor_si128(hi, _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x11), _mm_srli_si128(mid, 8)));
+}
+
+__attribute__((target("pclmul,ssse3"))) inline __m128i reduce_x86(__m128i lo, __m128i hi) {
+  // Shift the 256-bit product left by one.
+  __m128i lo_carry  = _mm_srli_epi32(lo, 31);
+  __m128i hi_carry  = _mm_srli_epi32(hi, 31);
+  lo                = _mm_slli_epi32(lo, 1);
+  hi                = _mm_slli_epi32(hi, 1);
+  const __m128i top = _mm_srli_si128(lo_carry, 12);
+  hi_carry          = _mm_slli_si128(hi_carry, 4);
+  lo_carry          = _mm_slli_si128(lo_carry, 4);
+  lo                = _mm_or_si128(lo, lo_carry);
+  hi                = _mm_or_si128(_mm_or_si128(hi, hi_carry), top);
+  // Reduce.
+  __m128i t =
+      _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)), _mm_slli_epi32(lo, 25));
+  const __m128i t_hi = _mm_srli_si128(t, 4);
+  lo                 = _mm_xor_si128(lo, _mm_slli_si128(t, 12));
+  __m128i u =
+      _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)), _mm_srli_epi32(lo, 7));
+  u         = _mm_xor_si128(u, t_hi);
+  return _mm_xor_si128(hi, _mm_xor_si128(lo, u));
+}
+
+__attribute__((target("ssse3"))) inline __m128i load_reversed_x86(const uint8_t* p) {
+  const __m128i rev = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  return _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), rev);
+}
+
+// Four blocks per reduction: y' = (y ^ b0)·H^4 ^ b1·H^3 ^ b2·H^2 ^ b3·H.
+__attribute__((target("pclmul,ssse3"))) void ghash_x86(const uint8_t* h, uint8_t* y, const uint8_t* data,
+                                                        size_t len) {
+  const __m128i rev = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  const __m128i h1  = load_reversed_x86(h), h2 = load_reversed_x86(h + 16);
+  const __m128i h3  = load_reversed_x86(h + 32), h4 = load_reversed_x86(h + 48);
+  __m128i acc       = load_reversed_x86(y);
+  for (; len >= 64; len -= 64, data += 64) {
+    __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+    clmul_acc_x86(_mm_xor_si128(acc, load_reversed_x86(data)), h4, lo, hi);
+    clmul_acc_x86(load_reversed_x86(data + 16), h3, lo, hi);
+    clmul_acc_x86(load_reversed_x86(data + 32), h2, lo, hi);
+    clmul_acc_x86(load_reversed_x86(data + 48), h1, lo, hi);
+    acc = reduce_x86(lo, hi);
+  }
+  while (len) {
+    alignas(16) uint8_t block[16] = {};
+    const size_t n                = len < 16 ? len : 16;
+    std::memcpy(block, data, n);
+    __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+    clmul_acc_x86(_mm_xor_si128(acc, load_reversed_x86(block)), h1, lo, hi);
+    acc = reduce_x86(lo, hi);
+    data += n;
+    len -= n;
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(y), _mm_shuffle_epi8(acc, rev));
+}
+
+// One group of four SHA-1 rounds; the function selector must be an immediate.
+template <int F>
+__attribute__((target("sha,sse4.1"))) inline __m128i sha1_rounds_x86(__m128i abcd, __m128i e) {
+  return _mm_sha1rnds4_epu32(abcd, e, F);
+}
+
+__attribute__((target("sha,sse4.1"))) void sha1_x86(uint32_t* h, const uint8_t* data, size_t blocks) {
+  const __m128i rev = _mm_set_epi64x(0x0001020304050607ull, 0x08090a0b0c0d0e0full);
+  __m128i abcd      = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h)), 0x1B);
+  __m128i e0        = _mm_set_epi32(static_cast<int>(h[4]), 0, 0, 0);
+  for (; blocks; --blocks, data += 64) {
+    const __m128i abcd_save = abcd, e_save = e0;
+    __m128i w[4];
+    for (int i = 0; i < 4; ++i)
+      w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), rev);
+    __m128i e = e0;  // E for the next group, before the schedule word is added
+#pragma GCC unroll 20
+    for (int g = 0; g < 20; ++g) {
+      // W[4g..4g+3] = rol1(W[t-3] ^ W[t-8] ^ W[t-14] ^ W[t-16]), four at a time.
+      if (g >= 4)
+        w[g & 3] = _mm_sha1msg2_epu32(
+            _mm_xor_si128(_mm_sha1msg1_epu32(w[g & 3], w[(g + 1) & 3]), w[(g + 2) & 3]), w[(g + 3) & 3]);
+      const __m128i e_in = g == 0 ? _mm_add_epi32(e, w[0]) : _mm_sha1nexte_epu32(e, w[g & 3]);
+      e                  = abcd;
+      switch (g / 5) {
+        case 0: abcd = sha1_rounds_x86<0>(abcd, e_in); break;
+        case 1: abcd = sha1_rounds_x86<1>(abcd, e_in); break;
+        case 2: abcd = sha1_rounds_x86<2>(abcd, e_in); break;
+        default: abcd = sha1_rounds_x86<3>(abcd, e_in); break;
+      }
+    }
+    e0   = _mm_sha1nexte_epu32(e, e_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(h), _mm_shuffle_epi32(abcd, 0x1B));
+  h[4] = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+}
+#endif  // RTP_SRTP_X86
+
+// ---- AArch64: ARMv8 Cryptography Extension --------------------------------------------
+
+#if RTP_SRTP_ARM
+__attribute__((target("+crypto"))) void aes_block_arm(const uint8_t* rk, const uint8_t* in, uint8_t* out) {
+  uint8x16_t b = vld1q_u8(in);
+  for (int r = 0; r < 9; ++r) b = vaesmcq_u8(vaeseq_u8(b, vld1q_u8(rk + 16 * r)));
+  b = veorq_u8(vaeseq_u8(b, vld1q_u8(rk + 144)), vld1q_u8(rk + 160));
+  vst1q_u8(out, b);
+}
+
+__attribute__((target("+crypto"))) inline uint8x16_t counter_arm(uint32x4_t base, uint32_t n) {
+  return vreinterpretq_u8_u32(vsetq_lane_u32(__builtin_bswap32(n), base, 3));
+}
+
+__attribute__((target("+crypto"))) void ctr_xor_arm(const uint8_t* rk, const uint8_t* ctr, uint8_t* data,
+                                                     size_t len) {
+  uint8x16_t k[11];
+  for (int r = 0; r < 11; ++r) k[r] = vld1q_u8(rk + 16 * r);
+  const uint32x4_t base = vreinterpretq_u32_u8(vld1q_u8(ctr));
+  uint32_t c            = be32(ctr + 12);
+  for (; len >= 64; len -= 64, data += 64, c += 4) {
+    uint8x16_t b0 = counter_arm(base, c), b1 = counter_arm(base, c + 1);
+    uint8x16_t b2 = counter_arm(base, c + 2), b3 = counter_arm(base, c + 3);
+    for (int r = 0; r < 9; ++r) {
+      b0 = vaesmcq_u8(vaeseq_u8(b0, k[r]));
+      b1 = vaesmcq_u8(vaeseq_u8(b1, k[r]));
+      b2 = vaesmcq_u8(vaeseq_u8(b2, k[r]));
+      b3 = vaesmcq_u8(vaeseq_u8(b3, k[r]));
+    }
+    vst1q_u8(data, veorq_u8(vld1q_u8(data), veorq_u8(vaeseq_u8(b0, k[9]), k[10])));
+    vst1q_u8(data + 16, veorq_u8(vld1q_u8(data + 16), veorq_u8(vaeseq_u8(b1, k[9]), k[10])));
+    vst1q_u8(data + 32, veorq_u8(vld1q_u8(data + 32), veorq_u8(vaeseq_u8(b2, k[9]), k[10])));
+    vst1q_u8(data + 48, veorq_u8(vld1q_u8(data + 48), veorq_u8(vaeseq_u8(b3, k[9]), k[10])));
+  }
+  for (; len; ++c) {
+    uint8x16_t b = counter_arm(base, c);
+    for (int r = 0; r < 9; ++r) b = vaesmcq_u8(vaeseq_u8(b, k[r]));
+    uint8_t ks[16];
+    vst1q_u8(ks, veorq_u8(vaeseq_u8(b, k[9]), k[10]));
+    const size_t n = len < 16 ? len : 16;
+    for (size_t i = 0; i < n; ++i) data[i] ^= ks[i];
+    data += n;
+    len -= n;
+  }
+}
+
+__attribute__((target("+crypto"))) inline uint8x16_t clmul_arm(uint64_t x, uint64_t y) {
+  return vreinterpretq_u8_p128(vmull_p64(static_cast<poly64_t>(x), static_cast<poly64_t>(y)));
+}
+
+// The x86 split multiply above, in NEON: byte shifts by vextq against zero.
+__attribute__((target("+crypto"))) inline void clmul_acc_arm(uint8x16_t a8, uint8x16_t b8, uint8x16_t& lo,
+                                                              uint8x16_t& hi) {
+  const uint64x2_t a   = vreinterpretq_u64_u8(a8);
+  const uint64x2_t b   = vreinterpretq_u64_u8(b8);
+  const uint8x16_t z   = vdupq_n_u8(0);
+  const uint8x16_t mid = veorq_u8(clmul_arm(vgetq_lane_u64(a, 0), vgetq_lane_u64(b, 1)),
+                                  clmul_arm(vgetq_lane_u64(a, 1), vgetq_lane_u64(b, 0)));
+  lo = veorq_u8(lo, veorq_u8(clmul_arm(vgetq_lane_u64(a, 0), vgetq_lane_u64(b, 0)), vextq_u8(z, mid, 8)));
+  hi = veorq_u8(hi, veorq_u8(clmul_arm(vgetq_lane_u64(a, 1), vgetq_lane_u64(b, 1)), vextq_u8(mid, z, 8)));
+}
+
+__attribute__((target("+crypto"))) inline uint8x16_t reduce_arm(uint8x16_t lo, uint8x16_t hi) {
+  const uint8x16_t z    = vdupq_n_u8(0);
+  uint32x4_t l          = vreinterpretq_u32_u8(lo);
+  uint32x4_t h          = vreinterpretq_u32_u8(hi);
+  uint32x4_t l_carry    = vshrq_n_u32(l, 31);
+  uint32x4_t h_carry    = vshrq_n_u32(h, 31);
+  l                     = vshlq_n_u32(l, 1);
+  h                     = vshlq_n_u32(h, 1);
+  const uint32x4_t top  = vreinterpretq_u32_u8(vextq_u8(vreinterpretq_u8_u32(l_carry), z, 12));
+  h_carry               = vreinterpretq_u32_u8(vextq_u8(z, vreinterpretq_u8_u32(h_carry), 12));
+  l_carry               = vreinterpretq_u32_u8(vextq_u8(z, vreinterpretq_u8_u32(l_carry), 12));
+  l                     = vorrq_u32(l, l_carry);
+  h                     = vorrq_u32(vorrq_u32(h, h_carry), top);
+  uint32x4_t t          = veorq_u32(veorq_u32(vshlq_n_u32(l, 31), vshlq_n_u32(l, 30)), vshlq_n_u32(l, 25));
+  const uint32x4_t t_hi = vreinterpretq_u32_u8(vextq_u8(vreinterpretq_u8_u32(t), z, 4));
+  l                     = veorq_u32(l, vreinterpretq_u32_u8(vextq_u8(z, vreinterpretq_u8_u32(t), 4)));
+  uint32x4_t u          = veorq_u32(veorq_u32(vshrq_n_u32(l, 1), vshrq_n_u32(l, 2)), vshrq_n_u32(l, 7));
+  u                     = veorq_u32(u, t_hi);
+  return vreinterpretq_u8_u32(veorq_u32(h, veorq_u32(l, u)));
+}
+
+__attribute__((target("+crypto"))) inline uint8x16_t load_reversed_arm(const uint8_t* p) {
+  const uint8x16_t v = vrev64q_u8(vld1q_u8(p));
+  return vextq_u8(v, v, 8);
+}
+
+__attribute__((target("+crypto"))) void ghash_arm(const uint8_t* h, uint8_t* y, const uint8_t* data,
+                                                   size_t len) {
+  const uint8x16_t h1 = load_reversed_arm(h), h2 = load_reversed_arm(h + 16);
+  const uint8x16_t h3 = load_reversed_arm(h + 32), h4 = load_reversed_arm(h + 48);
+  const uint8x16_t z  = vdupq_n_u8(0);
+  uint8x16_t acc      = load_reversed_arm(y);
+  for (; len >= 64; len -= 64, data += 64) {
+    uint8x16_t lo = z, hi = z;
+    clmul_acc_arm(veorq_u8(acc, load_reversed_arm(data)), h4, lo, hi);
+    clmul_acc_arm(load_reversed_arm(data + 16), h3, lo, hi);
+    clmul_acc_arm(load_reversed_arm(data + 32), h2, lo, hi);
+    clmul_acc_arm(load_reversed_arm(data + 48), h1, lo, hi);
+    acc = reduce_arm(lo, hi);
+  }
+  while (len) {
+    uint8_t block[16] = {};
+    const size_t n    = len < 16 ? len : 16;
+    std::memcpy(block, data, n);
+    uint8x16_t lo = z, hi = z;
+    clmul_acc_arm(veorq_u8(acc, load_reversed_arm(block)), h1, lo, hi);
+    acc = reduce_arm(lo, hi);
+    data += n;
+    len -= n;
+  }
+  uint8_t out[16];
+  vst1q_u8(out, acc);
+  for (int i = 0; i < 16; ++i) y[i] = out[15 - i];
+}
+
+__attribute__((target("+crypto"))) void sha1_arm(uint32_t* h, const uint8_t* data, size_t blocks) {
+  static const uint32_t kK[4] = {0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6};
+  uint32x4_t abcd             = vld1q_u32(h);
+  uint32_t e0                 = h[4];
+  for (; blocks; --blocks, data += 64) {
+    const uint32x4_t abcd_save = abcd;
+    const uint32_t e_save      = e0;
+    uint32x4_t w[4];
+    for (int i = 0; i < 4; ++i) w[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+    uint32_t e = e0;
+#pragma GCC unroll 20
+    for (int g = 0; g < 20; ++g) {
+      if (g >= 4)
+        w[g & 3] = vsha1su1q_u32(vsha1su0q_u32(w[g & 3], w[(g + 1) & 3], w[(g + 2) & 3]), w[(g + 3) & 3]);
+      const uint32x4_t wk = vaddq_u32(w[g & 3], vdupq_n_u32(kK[g / 5]));
+      const uint32_t next = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+      switch (g / 5) {
+        case 0: abcd = vsha1cq_u32(abcd, e, wk); break;
+        case 2: abcd = vsha1mq_u32(abcd, e, wk); break;
+        default: abcd = vsha1pq_u32(abcd, e, wk); break;
+      }
+      e = next;
+    }
+    abcd = vaddq_u32(abcd, abcd_save);
+    e0   = e + e_save;
+  }
+  vst1q_u32(h, abcd);
+  h[4] = e0;
+}
+#endif  // RTP_SRTP_ARM
+
+// ---- dispatch ---------------------------------------------------------------------------
+
+struct Impl {
+  void (*block)(const uint8_t*, const uint8_t*, uint8_t*)               = aes_block_portable;
+  void (*ctr)(const uint8_t*, const uint8_t*, uint8_t*, size_t)         = ctr_xor_portable;
+  void (*ghash)(const uint8_t*, uint8_t*, const uint8_t*, size_t)       = ghash_portable;
+  void (*sha1)(uint32_t*, const uint8_t*, size_t)                       = sha1_portable;
+  char name[48]                                                         = "portable";
+};
+
+Impl choose(bool extensions) {
+  Impl impl;
+  if (!extensions) return impl;
+  const Cpu cpu = detect();
+  const char* parts[3];
+  size_t n = 0;
+#if RTP_SRTP_X86
+  if (cpu.aes) {
+    impl.block = aes_block_x86;
+    impl.ctr   = ctr_xor_x86;
+    parts[n++] = "AES-NI";
+  }
+  if (cpu.clmul) {
+    impl.ghash = ghash_x86;
+    parts[n++] = "PCLMUL";
+  }
+  if (cpu.sha1) {
+    impl.sha1  = sha1_x86;
+    parts[n++] = "SHA-NI";
+  }
+#elif RTP_SRTP_ARM
+  if (cpu.aes) {
+    impl.block = aes_block_arm;
+    impl.ctr   = ctr_xor_arm;
+    parts[n++] = "ARMv8 AES";
+  }
+  if (cpu.clmul) {
+    impl.ghash = ghash_arm;
+    parts[n++] = "PMULL";
+  }
+  if (cpu.sha1) {
+    impl.sha1  = sha1_arm;
+    parts[n++] = "ARMv8 SHA1";
+  }
+#else
+  (void)cpu;
+#endif
+  for (size_t i = 0, at = 0; i < n; ++i)
+    at += static_cast<size_t>(
+        std::snprintf(impl.name + at, sizeof(impl.name) - at, "%s%s", i ? ", " : "", parts[i]));
+  return impl;
+}
+
+Impl& impl() {
+  static Impl chosen = choose(true);
+  return chosen;
+}
+
+}  // namespace
+
+Cpu detect() {
+  Cpu cpu;
+#if RTP_SRTP_X86
+  unsigned a, b, c, d;
+  if (__get_cpuid(1, &a, &b, &c, &d)) {
+    const bool sse41 = c & bit_SSE4_1;
+    cpu.aes          = sse41 && (c & bit_AES);
+    cpu.clmul        = (c & bit_SSSE3) && (c & bit_PCLMUL);
+    if (__get_cpuid_count(7, 0, &a, &b, &c, &d)) cpu.sha1 = sse41 && (b & bit_SHA);
+  }
+#elif RTP_SRTP_ARM
+  const unsigned long hw = ::getauxval(AT_HWCAP);
+  cpu.aes                = hw & HWCAP_AES;
+  cpu.clmul              = hw & HWCAP_PMULL;
+  cpu.sha1               = hw & HWCAP_SHA1;
+#endif
+  return cpu;
+}
+
+void use_extensions(bool on) { impl() = choose(on); }
+
+const char* backend() { return impl().name; }
+
+// ---- AES-128 ------------------------------------------------------------------------------
+
+void Aes128::set_key(const uint8_t key[16]) {
+  // FIPS-197 key expansion. The round keys are in the byte order AES-NI and AESE take too.
+  const uint8_t* S = sbox().s;
+  std::memcpy(rk_, key, 16);
+  uint8_t rcon = 1;
+  for (size_t i = 16; i < sizeof(rk_); i += 4) {
+    uint8_t t[4] = {rk_[i - 4], rk_[i - 3], rk_[i - 2], rk_[i - 1]};
+    if (i % 16 == 0) {
+      const uint8_t t0 = t[0];
+      t[0]             = static_cast<uint8_t>(S[t[1]] ^ rcon);
+      t[1]             = S[t[2]];
+      t[2]             = S[t[3]];
+      t[3]             = S[t0];
+      rcon             = xtime(rcon);
+    }
+    for (int j = 0; j < 4; ++j) rk_[i + j] = rk_[i - 16 + j] ^ t[j];
+  }
+}
+
+void Aes128::encrypt_block(const uint8_t in[16], uint8_t out[16]) const { impl().block(rk_, in, out); }
+
+void Aes128::ctr_xor(const uint8_t ctr[16], uint8_t* data, size_t len) const {
+  impl().ctr(rk_, ctr, data, len);
+}
+
+// ---- SHA-1 / HMAC -----------------------------------------------------------------------
+
+namespace {
+
+// Streaming SHA-1 on top of the selected compression function. `h` and `len` may start
+// from a state that has already absorbed whole blocks (HMAC's key pads).
+struct Sha1 {
+  uint32_t h[5];
+  uint8_t buf[64];
+  size_t used  = 0;
+  uint64_t len = 0;  // bytes, the absorbed prefix included
+
+  void update(const uint8_t* p, size_t n) {
+    len += n;
+    if (used) {
+      const size_t take = std::min(n, 64 - used);
+      std::memcpy(buf + used, p, take);
+      used += take;
+      p += take;
+      n -= take;
+      if (used < 64) return;
+      impl().sha1(h, buf, 1);
+      used = 0;
+    }
+    if (n >= 64) {
+      impl().sha1(h, p, n / 64);
+      p += n & ~size_t{63};
+      n &= 63;
+    }
+    std::memcpy(buf, p, n);
+    used = n;
+  }
+  void final(uint8_t out[20]) {
+    const uint64_t bits = len * 8;
+    const uint8_t one   = 0x80;
+    update(&one, 1);
+    static const uint8_t zeros[64] = {};
+    update(zeros, (used <= 56 ? 56 : 120) - used);
+    uint8_t tail[8];
+    put_be64(tail, bits);
+    update(tail, 8);
+    for (int i = 0; i < 5; ++i) put_be32(out + 4 * i, h[i]);
+  }
+};
+
+constexpr uint32_t kSha1Init[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+}  // namespace
+
+void HmacSha1::set_key(const uint8_t* key, size_t len) {
+  uint8_t k[64] = {};
+  if (len > 64) {
+    Sha1 s;
+    std::memcpy(s.h, kSha1Init, sizeof(s.h));
+    s.update(key, len);
+    s.final(k);
+  } else {
+    std::memcpy(k, key, len);
+  }
+  uint8_t pad[64];
+  for (int i = 0; i < 64; ++i) pad[i] = k[i] ^ 0x36;
+  std::memcpy(inner_, kSha1Init, sizeof(inner_));
+  impl().sha1(inner_, pad, 1);
+  for (int i = 0; i < 64; ++i) pad[i] = k[i] ^ 0x5C;
+  std::memcpy(outer_, kSha1Init, sizeof(outer_));
+  impl().sha1(outer_, pad, 1);
+}
+
+void HmacSha1::mac(const uint8_t* a, size_t a_len, const uint8_t* b, size_t b_len, uint8_t out[20]) const {
+  Sha1 s;
+  std::memcpy(s.h, inner_, sizeof(s.h));
+  s.len = 64;
+  s.update(a, a_len);
+  s.update(b, b_len);
+  uint8_t inner_digest[20];
+  s.final(inner_digest);
+  Sha1 o;
+  std::memcpy(o.h, outer_, sizeof(o.h));
+  o.len = 64;
+  o.update(inner_digest, 20);
+  o.final(out);
+}
+
+// ---- GCM ----------------------------------------------------------------------------------
+
+void Gcm128::set_key(const uint8_t key[16]) {
+  aes_.set_key(key);
+  const uint8_t zero[16] = {};
+  aes_.encrypt_block(zero, h_);
+  // H^2..H^4 for the backends that fold four blocks per reduction.
+  for (int i = 1; i < 4; ++i) {
+    std::memset(h_ + 16 * i, 0, 16);
+    ghash_portable(h_, h_ + 16 * i, h_ + 16 * (i - 1), 16);
+  }
+}
+
+void Gcm128::tag_of(const uint8_t iv[12], const uint8_t* aad, size_t aad_len, const uint8_t* data,
+                    size_t len, uint8_t tag[16]) const {
+  uint8_t y[16] = {};
+  impl().ghash(h_, y, aad, aad_len);
+  impl().ghash(h_, y, data, len);
+  uint8_t lengths[16];
+  put_be64(lengths, uint64_t{aad_len} * 8);
+  put_be64(lengths + 8, uint64_t{len} * 8);
+  impl().ghash(h_, y, lengths, 16);
+  uint8_t j0[16];
+  std::memcpy(j0, iv, 12);
+  put_be32(j0 + 12, 1);
+  aes_.encrypt_block(j0, tag);
+  for (int i = 0; i < 16; ++i) tag[i] ^= y[i];
+}
+
+void Gcm128::seal(const uint8_t iv[12], const uint8_t* aad, size_t aad_len, uint8_t* data, size_t len,
+                  uint8_t tag[16]) const {
+  uint8_t ctr[16];
+  std::memcpy(ctr, iv, 12);
+  put_be32(ctr + 12, 2);
+  aes_.ctr_xor(ctr, data, len);
+  tag_of(iv, aad, aad_len, data, len, tag);
+}
+
+bool Gcm128::open(const uint8_t iv[12], const uint8_t* aad, size_t aad_len, uint8_t* data, size_t len,
+                  const uint8_t tag[16]) const {
+  uint8_t expect[16];
+  tag_of(iv, aad, aad_len, data, len, expect);
+  uint8_t diff = 0;
+  for (int i = 0; i < 16; ++i) diff |= expect[i] ^ tag[i];
+  if (diff) return false;
+  uint8_t ctr[16];
+  std::memcpy(ctr, iv, 12);
+  put_be32(ctr + 12, 2);
+  aes_.ctr_xor(ctr, data, len);
+  return true;
+}
+
+// ---- SRTP ---------------------------------------------------------------------------------
+
+bool Context::set_key(Suite suite, const uint8_t* key, size_t key_len, const uint8_t* salt,
+                      size_t salt_len) {
+  const bool gcm = suite == Suite::kAeadAes128Gcm;
+  if (key_len != 16 || salt_len != (gcm ? 12u : 14u)) return false;
+  suite_ = suite;
+  // AES-CM PRF: the keystream under the master key, IV = master salt (a GCM salt zero-
+  // padded to 112 bits) XOR the label in byte 7; key derivation rate 0, so no index.
+  Aes128 master;
+  master.set_key(key);
+  auto derive = [&](uint8_t label, uint8_t* out, size_t n) {
+    uint8_t iv[16] = {};
+    std::memcpy(iv, salt, salt_len);
+    iv[7] ^= label;
+    std::memset(out, 0, n);
+    master.ctr_xor(iv, out, n);
+  };
+  uint8_t session_key[16];
+  derive(0x00, session_key, 16);
+  derive(0x02, salt_, gcm ? 12 : 14);
+  if (gcm) {
+    gcm_.set_key(session_key);
+  } else {
+    aes_.set_key(session_key);
+    uint8_t auth_key[20];
+    derive(0x01, auth_key, 20);
+    hmac_.set_key(auth_key, 20);
+  }
+  return true;
+}
+
+// RFC 3711 §4.1.1: (salt << 16) ^ (SSRC << 64) ^ (index << 16).
+void Context::cm_iv(const uint8_t* pkt, uint64_t index, uint8_t iv[16]) const {
+  std::memcpy(iv, salt_, 14);
+  iv[14] = iv[15] = 0;
+  for (int i = 0; i < 4; ++i) iv[4 + i] ^= pkt[8 + i];
+  for (int i = 0; i < 6; ++i) iv[8 + i] ^= static_cast<uint8_t>(index >> (40 - 8 * i));
+}
+
+// RFC 7714 §8.1: (00 00 || SSRC || ROC || SEQ) ^ salt.
+void Context::gcm_iv(const uint8_t* pkt, uint64_t index, uint8_t iv[12]) const {
+  uint8_t v[12] = {0, 0};
+  std::memcpy(v + 2, pkt + 8, 4);
+  put_be32(v + 6, static_cast<uint32_t>(index >> 16));
+  v[10] = static_cast<uint8_t>(index >> 8);
+  v[11] = static_cast<uint8_t>(index);
+  for (int i = 0; i < 12; ++i) iv[i] = v[i] ^ salt_[i];
+}
+
+bool Context::unprotect(uint8_t* pkt, size_t len, size_t hdr, uint64_t index) const {
+  const size_t tag = overhead();
+  if (len < hdr + tag) return false;
+  const size_t end = len - tag;
+  if (suite_ == Suite::kAeadAes128Gcm) {
+    uint8_t iv[12];
+    gcm_iv(pkt, index, iv);
+    return gcm_.open(iv, pkt, hdr, pkt + hdr, end - hdr, pkt + end);
+  }
+  // Authenticated: the whole packet and the ROC (RFC 3711 §4.2).
+  uint8_t roc[4], mac[20];
+  put_be32(roc, static_cast<uint32_t>(index >> 16));
+  hmac_.mac(pkt, end, roc, 4, mac);
+  uint8_t diff = 0;
+  for (size_t i = 0; i < tag; ++i) diff |= mac[i] ^ pkt[end + i];
+  if (diff) return false;
+  uint8_t iv[16];
+  cm_iv(pkt, index, iv);
+  aes_.ctr_xor(iv, pkt + hdr, end - hdr);
+  return true;
+}
+
+size_t Context::protect(uint8_t* pkt, size_t len, size_t hdr, uint64_t index) const {
+  if (suite_ == Suite::kAeadAes128Gcm) {
+    uint8_t iv[12];
+    gcm_iv(pkt, index, iv);
+    gcm_.seal(iv, pkt, hdr, pkt + hdr, len - hdr, pkt + len);
+    return len + 16;
+  }
+  uint8_t iv[16];
+  cm_iv(pkt, index, iv);
+  aes_.ctr_xor(iv, pkt + hdr, len - hdr);
+  uint8_t roc[4], mac[20];
+  put_be32(roc, static_cast<uint32_t>(index >> 16));
+  hmac_.mac(pkt, len, roc, 4, mac);
+  std::memcpy(pkt + len, mac, 10);
+  return len + 10;
+}
+
+}  // namespace srtp
+}  // namespace rtp
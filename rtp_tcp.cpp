@@ -0,0 +1,134 @@
+// RTP over TCP ingest for rtp::Receiver (Receiver::Ingest::kTcp), RFC 4571 framing: each
+// packet is preceded by its length as a 16-bit big-endian integer.
+//
+// The recv thread listens on the receive address and serves one sender connection at a
+// time; when it closes, the next one is accepted. Each recv() asks for tcp_read_bytes_ of
+// the byte stream into a staging buffer, and the frames in it are copied once each into
+// a slab run of the right length — the same single copy the packet_ring backend makes.
+// A frame cut off at the end of a read is moved to the front of the buffer to be
+// completed by the next.
+//
+// TCP delivers in order and without loss, so frames skip the jitter ring
+// (handle_inorder): no reordering to wait for, and the packets of one read go to the
+// worker with one publish. Nor is there a reason to drop when the pool runs dry: the
+// recv thread waits for slabs instead, and the sender is slowed down by TCP flow control.
+// The wait is bounded (kStreamSlabWaitMs) in case the hook is holding the whole pool on
+// an incomplete frame; past it the packet is dropped and counted busy, as over UDP, so
+// the packets behind it can complete the frame.
+#include "rtp_receiver.hpp"
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace rtp {
+
+namespace {
+constexpr size_t kFrameMax        = 2 + 65535;  // length prefix + the largest frame
+constexpr size_t kMinTcpReadBytes = 128 * 1024;
+constexpr int kStreamSlabWaitMs   = 20;
+constexpr int kStreamSlabPollUs   = 50;
+}  // namespace
+
+// Creates, configures, binds and listens on the TCP socket. -1 on failure (logged).
+int Receiver::open_tcp_listener(const sockaddr_in& addr) {
+  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+  if (fd < 0) {
+    std::cerr << "rtp::Receiver: socket(TCP) failed: " << std::strerror(errno) << std::endl;
+    return -1;
+  }
+  int reuse = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  if (rcvbuf_size_ > 0) {
+    // Set on the listener, inherited by the accepted connection; before listen() so the
+    // window scale is negotiated for it.
+    if (::setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf_size_, sizeof(rcvbuf_size_)) < 0) {
+      ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf_size_, sizeof(rcvbuf_size_));
+    }
+  }
+  if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 1) < 0) {
+    std::cerr << "rtp::Receiver: bind()/listen() (TCP) failed: " << std::strerror(errno) << std::endl;
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// A slab run for a `len`-byte frame. Waits up to kStreamSlabWaitMs for the worker to free
+// one (jobs already parsed from this read are published first, or it never would).
+size_t Receiver::acquire_stream_slab(size_t len) {
+  const size_t run = slabs_for(len);
+  size_t slab      = acquire_slab(run);
+  if (slab != kNoSlab) return slab;
+  publish_jobs();
+  const auto give_up = std::chrono::steady_clock::now() + std::chrono::milliseconds(kStreamSlabWaitMs);
+  while (running_.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < give_up) {
+    std::this_thread::sleep_for(std::chrono::microseconds(kStreamSlabPollUs));
+    slab = acquire_slab(run);
+    if (slab != kNoSlab) return slab;
+  }
+  return kNoSlab;
+}
+
+void Receiver::recv_loop_tcp() {
+  std::vector<uint8_t> buf(std::max(tcp_read_bytes_, kMinTcpReadBytes) + kFrameMax);
+  const size_t read_bytes = buf.size() - kFrameMax;
+  int conn                = -1;
+  size_t have             = 0;  // bytes in buf: at most one partial frame between reads
+
+  while (running_.load(std::memory_order_acquire)) {
+    if (conn < 0) {
+      pollfd pfd{sock_fd_, POLLIN, 0};
+      if (::poll(&pfd, 1, 100) <= 0) continue;  // the timeout re-checks running_
+      conn = ::accept4(sock_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+      have = 0;
+      continue;
+    }
+    pollfd pfd{conn, POLLIN, 0};
+    if (::poll(&pfd, 1, 100) <= 0) continue;
+    const ssize_t n = ::recv(conn, buf.data() + have, read_bytes, MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+      // Sender gone; a frame it left unfinished is lost with it.
+      ::close(conn);
+      conn = -1;
+      continue;
+    }
+    if (n < 0) continue;
+    recv_calls_.fetch_add(1, std::memory_order_relaxed);
+    have += static_cast<size_t>(n);
+
+    size_t pos    = 0;
+    size_t frames = 0;
+    while (have - pos >= 2) {
+      const size_t len = static_cast<size_t>(buf[pos] << 8 | buf[pos + 1]);
+      if (have - pos - 2 < len) break;
+      uint8_t* frame = buf.data() + pos + 2;
+      pos += 2 + len;
+      ++frames;
+      if (len < 12 || len > max_datagram_) continue;
+      const size_t slab = acquire_stream_slab(len);
+      if (slab == kNoSlab) {
+        handle_inorder(frame, len, kNoSlab);
+        continue;
+      }
+      std::memcpy(slab_ptr(slab), frame, len);
+      if (!handle_inorder(slab_ptr(slab), len, slab)) free_slab(slab);
+    }
+    recv_datagrams_.fetch_add(frames, std::memory_order_relaxed);
+    publish_jobs();
+    have -= pos;
+    if (have && pos) std::memmove(buf.data(), buf.data() + pos, have);
+  }
+  if (conn >= 0) ::close(conn);
+}
+
+}  // namespace rtp
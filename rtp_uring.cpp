@@ -0,0 +1,307 @@
+// io_uring ingest backend for rtp::Receiver (Receiver::Ingest::kIoUring).
+//
+// One multishot IORING_OP_RECV stays armed on the UDP socket. Its buffers come from a
+// registered provided-buffer ring (IORING_REGISTER_PBUF_RING) whose entries ARE slab
+// pool slots: the buffer id the kernel reports in each completion is the slab index, so
+// the datagram is already where handle_dgram wants it. The recv thread only enters the
+// kernel to wait when the completion queue is empty; under load one io_uring_enter
+// reaps a whole burst of completions.
+//
+// Slot recycling: a slab that handle_dgram rejects (late, duplicate, alias) is put
+// straight back on the buffer ring; a consumed one is replaced with a fresh
+// acquire_slab(). The buffer ring has a single producer, so the worker's release_slab()
+// stays a plain store and the recv thread re-provides on its side, once per completion
+// batch. Multishot recv with provided-buffer rings needs Linux 6.0+.
+#include "rtp_receiver.hpp"
+
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace rtp {
+
+namespace {
+constexpr unsigned kUringEntries = 8;     // SQ depth: one multishot recv, re-armed on demand
+constexpr unsigned kUringCqSize  = 4096;  // ~55 ms of 4K@60 packets before CQ overflow
+constexpr uint16_t kBufGroup     = 0;
+
+int uring_setup(unsigned entries, io_uring_params* p) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+}
+int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, void* arg, size_t argsz) {
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz));
+}
+int uring_register(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+  return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+}  // namespace
+
+struct Receiver::UringState {
+  int fd = -1;
+  // SQ / CQ rings (single mmap when IORING_FEAT_SINGLE_MMAP).
+  void* sq_map    = nullptr;
+  size_t sq_bytes = 0;
+  void* cq_map    = nullptr;
+  size_t cq_bytes = 0;
+  io_uring_sqe* sqes = nullptr;
+  size_t sqes_bytes  = 0;
+  unsigned* sq_tail  = nullptr;
+  unsigned* sq_mask  = nullptr;
+  unsigned* sq_array = nullptr;
+  unsigned* cq_head  = nullptr;
+  unsigned* cq_tail  = nullptr;
+  unsigned* cq_mask  = nullptr;
+  io_uring_cqe* cqes = nullptr;
+  // Provided-buffer ring.
+  io_uring_buf* bufs    = nullptr;
+  size_t bufs_bytes     = 0;
+  uint16_t buf_tail     = 0;  // local copy; published to the shared tail in batches
+  unsigned buf_entries  = 0;
+  unsigned buf_provided = 0;  // slabs currently owned by the kernel
+};
+
+bool Receiver::open_uring() {
+  if (slab_count_ > 65536) {
+    std::cerr << "rtp::Receiver: io_uring ingest addresses at most 65536 slabs (" << slab_count_
+              << " configured)" << std::endl;
+    return false;
+  }
+  // The kernel caps a buffer ring at 32768 entries, and provide_slab masks with
+  // buf_entries - 1.
+  if (uring_buffers_ == 0 || uring_buffers_ > 32768 || (uring_buffers_ & (uring_buffers_ - 1)) != 0) {
+    std::cerr << "rtp::Receiver: io_uring buffer ring size must be a power of two in [1, 32768] ("
+              << uring_buffers_ << " set by set_uring_buffers)" << std::endl;
+    return false;
+  }
+  auto* u = new UringState;
+  uring_  = u;
+
+  io_uring_params p{};
+  p.flags      = IORING_SETUP_CQSIZE;
+  p.cq_entries = kUringCqSize;
+  u->fd        = uring_setup(kUringEntries, &p);
+  if (u->fd < 0) {
+    std::cerr << "rtp::Receiver: io_uring_setup failed: " << std::strerror(errno) << std::endl;
+    close_uring();
+    return false;
+  }
+
+  u->sq_bytes = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  u->cq_bytes = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) u->sq_bytes = u->cq_bytes = std::max(u->sq_bytes, u->cq_bytes);
+  u->sq_map = ::mmap(nullptr, u->sq_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                     IORING_OFF_SQ_RING);
+  if (u->sq_map == MAP_FAILED) {
+    u->sq_map = nullptr;
+    std::cerr << "rtp::Receiver: mmap(io_uring SQ) failed: " << std::strerror(errno) << std::endl;
+    close_uring();
+    return false;
+  }
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    u->cq_map = u->sq_map;
+  } else {
+    u->cq_map = ::mmap(nullptr, u->cq_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                       IORING_OFF_CQ_RING);
+    if (u->cq_map == MAP_FAILED) {
+      u->cq_map = nullptr;
+      std::cerr << "rtp::Receiver: mmap(io_uring CQ) failed: " << std::strerror(errno) << std::endl;
+      close_uring();
+      return false;
+    }
+  }
+  u->sqes_bytes = p.sq_entries * sizeof(io_uring_sqe);
+  void* sqes    = ::mmap(nullptr, u->sqes_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                         IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    std::cerr << "rtp::Receiver: mmap(io_uring SQEs) failed: " << std::strerror(errno) << std::endl;
+    close_uring();
+    return false;
+  }
+  u->sqes = static_cast<io_uring_sqe*>(sqes);
+
+  auto* sq    = static_cast<uint8_t*>(u->sq_map);
+  auto* cq    = static_cast<uint8_t*>(u->cq_map);
+  u->sq_tail  = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+  u->sq_mask  = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+  u->sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+  u->cq_head  = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+  u->cq_tail  = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+  u->cq_mask  = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+  u->cqes     = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+  // Provided-buffer ring: page-aligned array of io_uring_buf; entry 0's resv field
+  // doubles as the shared tail.
+  u->buf_entries = static_cast<unsigned>(uring_buffers_);
+  u->bufs_bytes  = u->buf_entries * sizeof(io_uring_buf);
+  void* bufs     = ::mmap(nullptr, u->bufs_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (bufs == MAP_FAILED) {
+    std::cerr << "rtp::Receiver: mmap(buffer ring) failed: " << std::strerror(errno) << std::endl;
+    close_uring();
+    return false;
+  }
+  u->bufs = static_cast<io_uring_buf*>(bufs);
+  io_uring_buf_reg reg{};
+  reg.ring_addr    = reinterpret_cast<uint64_t>(u->bufs);
+  reg.ring_entries = u->buf_entries;
+  reg.bgid         = kBufGroup;
+  if (uring_register(u->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+    std::cerr << "rtp::Receiver: IORING_REGISTER_PBUF_RING failed: " << std::strerror(errno)
+              << " (needs Linux 5.19+)" << std::endl;
+    ::munmap(u->bufs, u->bufs_bytes);
+    u->bufs = nullptr;
+    close_uring();
+    return false;
+  }
+  return true;
+}
+
+void Receiver::close_uring() {
+  UringState* u = uring_;
+  if (!u) return;
+  if (u->sqes) ::munmap(u->sqes, u->sqes_bytes);
+  if (u->cq_map && u->cq_map != u->sq_map) ::munmap(u->cq_map, u->cq_bytes);
+  if (u->sq_map) ::munmap(u->sq_map, u->sq_bytes);
+  if (u->fd >= 0) ::close(u->fd);  // unregisters the buffer ring
+  if (u->bufs) ::munmap(u->bufs, u->bufs_bytes);
+  delete u;
+  uring_ = nullptr;
+}
+
+// Queue `slab` on the buffer ring (published by publish_provided).
+void Receiver::provide_slab(size_t slab) {
+  UringState* u   = uring_;
+  io_uring_buf& b = u->bufs[u->buf_tail & (u->buf_entries - 1)];
+  b.addr          = reinterpret_cast<uint64_t>(slab_ptr(slab));
+  b.len           = static_cast<uint32_t>(kSlabBytes);
+  b.bid           = static_cast<uint16_t>(slab);
+  u->buf_tail     = static_cast<uint16_t>(u->buf_tail + 1);
+  ++u->buf_provided;
+}
+
+void Receiver::publish_provided() {
+  UringState* u = uring_;
+  auto* tail    = reinterpret_cast<uint16_t*>(&u->bufs[0].resv);
+  __atomic_store_n(tail, u->buf_tail, __ATOMIC_RELEASE);
+}
+
+void Receiver::recv_loop_uring() {
+  UringState* u = uring_;
+  std::vector<uint8_t> scratch(max_datagram_);
+
+  auto arm_recv = [&] {
+    const unsigned tail = *u->sq_tail;
+    const unsigned idx  = tail & *u->sq_mask;
+    io_uring_sqe* sqe   = &u->sqes[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode      = IORING_OP_RECV;
+    sqe->fd          = sock_fd_;
+    sqe->flags       = IOSQE_BUFFER_SELECT;
+    sqe->ioprio      = IORING_RECV_MULTISHOT;
+    sqe->buf_group   = kBufGroup;
+    u->sq_array[idx] = idx;
+    __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  };
+  // Keep the kernel stocked with free slabs up to the buffer ring's capacity.
+  auto top_up = [&] {
+    while (u->buf_provided < u->buf_entries) {
+      const size_t slab = acquire_slab();
+      if (slab == kNoSlab) break;  // worker holds the pool; retry after the next batch
+      provide_slab(slab);
+    }
+    publish_provided();
+  };
+
+  unsigned to_submit = 0;
+  bool armed         = false;
+  bool warned_jumbo  = false;
+
+  __kernel_timespec ts{0, 100 * 1000 * 1000};  // 100 ms: notice stop() on an idle link
+  io_uring_getevents_arg arg{};
+  arg.sigmask_sz = _NSIG / 8;
+  arg.ts         = reinterpret_cast<uint64_t>(&ts);
+
+  while (running_.load(std::memory_order_acquire)) {
+    // (Re-)arm the multishot recv once the kernel has buffers again; it terminates on
+    // ENOBUFS when every provided slab is in use, with datagrams then waiting in the
+    // socket buffer.
+    if (!armed) {
+      top_up();
+      if (u->buf_provided > 0) {
+        arm_recv();
+        to_submit = 1;
+        armed     = true;
+      } else {
+        // Pool exhausted (the hook holds every slab). Keep draining the socket into
+        // scratch like the socket backend does: those datagrams are counted busy, and
+        // the packets that follow are what lets frame_handler reach EOC and release.
+        pollfd pfd{sock_fd_, POLLIN, 0};
+        if (::poll(&pfd, 1, 1) > 0) {
+          const ssize_t n = ::recv(sock_fd_, scratch.data(), scratch.size(), MSG_DONTWAIT);
+          if (n > 0) {
+            recv_calls_.fetch_add(1, std::memory_order_relaxed);
+            recv_datagrams_.fetch_add(1, std::memory_order_relaxed);
+          }
+          if (n >= 12) handle_dgram(scratch.data(), static_cast<size_t>(n), kNoSlab);
+        }
+        continue;
+      }
+    }
+    unsigned head = *u->cq_head;
+    if (head == __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE) || to_submit) {
+      const int rc = uring_enter(u->fd, to_submit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg,
+                                 sizeof(arg));
+      if (rc < 0 && errno != EINTR && errno != ETIME && errno != EBUSY) {
+        std::cerr << "rtp::Receiver: io_uring_enter failed: " << std::strerror(errno) << std::endl;
+        break;
+      }
+      if (rc >= 0) to_submit = 0;
+      head = *u->cq_head;
+    }
+    const unsigned tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail) continue;
+
+    recv_calls_.fetch_add(1, std::memory_order_relaxed);
+    for (; head != tail; ++head) {
+      const io_uring_cqe& cqe = u->cqes[head & *u->cq_mask];
+      if (!(cqe.flags & IORING_CQE_F_MORE)) armed = false;  // multishot ended (ENOBUFS, error)
+      if (!(cqe.flags & IORING_CQE_F_BUFFER)) continue;      // error completion, no buffer
+      const size_t slab = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+      u->buf_provided -= 1;
+      if (cqe.res < 12) {
+        provide_slab(slab);
+        continue;
+      }
+      recv_datagrams_.fetch_add(1, std::memory_order_relaxed);
+      if (static_cast<size_t>(cqe.res) >= kSlabBytes) {
+        // Filled the buffer: a jumbo datagram, truncated — multishot recv cannot scatter
+        // into a spill buffer. Dropped; the hole is counted as net loss.
+        if (!warned_jumbo) {
+          std::cerr << "rtp::Receiver: io_uring ingest takes datagrams up to " << kSlabBytes - 1
+                    << " bytes; dropping larger ones (use socket ingest for jumbo frames)" << std::endl;
+          warned_jumbo = true;
+        }
+        provide_slab(slab);
+        continue;
+      }
+      if (!handle_dgram(slab_ptr(slab), static_cast<size_t>(cqe.res), slab)) provide_slab(slab);
+    }
+    __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+    top_up();
+  }
+  // Slabs still on the buffer ring go back to the pool; start() resets every slab anyway.
+  const uint16_t end = u->buf_tail;
+  for (uint16_t t = static_cast<uint16_t>(end - u->buf_provided); t != end; ++t)
+    free_slab(u->bufs[t & (u->buf_entries - 1)].bid);
+}
+
+}  // namespace rtp
@@ -0,0 +1,34 @@
+// RTP wire-format helpers shared by rtp::Receiver's translation units: the version the
+// receiver accepts, big-endian field access and the monotonic clock arrival times and
+// deadlines are kept in. Internal; not part of the public API.
+#ifndef RTP_WIRE_HPP
+#define RTP_WIRE_HPP
+
+#include <chrono>
+#include <cstdint>
+
+namespace rtp {
+
+constexpr uint8_t kRtpVersion = 2;
+
+inline uint16_t rd_u16(const uint8_t* p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+inline uint32_t rd_u32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+         | (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+inline void wr_u16(uint8_t* p, uint16_t v) {
+  p[0] = static_cast<uint8_t>(v >> 8);
+  p[1] = static_cast<uint8_t>(v);
+}
+inline void wr_u32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (24 - 8 * i));
+}
+
+inline int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace rtp
+
+#endif  // RTP_WIRE_HPP
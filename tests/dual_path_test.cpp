@@ -0,0 +1,151 @@
+// dual_path_test — SMPTE 2022-7 dual-path merge in rtp::Receiver (set_redundant_path).
+//
+// A sender sends one RTP stream to two loopback ports, dropping a different set of
+// packets on each path, and a few on both. The hook must see every packet once, intact
+// and in order, except those lost on both paths; net_lost_packets() must count exactly
+// those, and path_lost() each path's own drops. Runs with the paths aligned, and
+// with path 1 trailing path 0 by kSkewPackets (well inside the jitter depth), where
+// path_skew_us() must come out positive. A third run uses the smallest pool and a hook
+// that stalls now and then, so the lanes drop whole batches busy: what is delivered must
+// still be intact and in order, and path_lost() / path_packets() must still count exactly each path's
+// own drops and receptions.
+//
+// usage: dual_path_test [packets=20000]
+// Exit status is non-zero on any mismatch.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "rtp_receiver.hpp"
+#include "rtp_test_sender.hpp"
+
+namespace {
+
+constexpr uint16_t kPort0      = 47200;
+constexpr uint16_t kPort1      = 47201;
+constexpr size_t kPayloadBytes = 1188;
+constexpr size_t kSkewPackets  = 32;
+// first_seq (wraps early in the run), ssrc, packets_per_ts, fill
+constexpr rtp_test::Stream kStream{65000, 0x2022, 100, 7};
+
+bool lost_on_both(size_t i, size_t packets) {
+  return i % 2500 == 1234 && !rtp_test::clean_tail(i, packets);
+}
+bool lost_on_path0(size_t i, size_t packets) { return i % 50 == 7 || lost_on_both(i, packets); }
+bool lost_on_path1(size_t i, size_t packets) {
+  return (i % 37 == 11 && !lost_on_path0(i, packets)) || lost_on_both(i, packets);
+}
+
+struct Sink {
+  rtp::Receiver *rx = nullptr;
+  size_t packets    = 0;
+  size_t next       = 0;  // next index expected at the hook
+  std::vector<uint16_t> seqs;
+  size_t bad_payload = 0;
+  bool stall         = false;  // stop for 20 ms every 2000 packets
+  size_t calls       = 0;
+};
+
+void on_packet(void *arg, const rtp::Frame &f) {
+  auto *s = static_cast<Sink *>(arg);
+  s->seqs.push_back(f.seq);
+  if (s->stall) {
+    // Whole stretches are dropped busy meanwhile: follow the sequence number forward.
+    s->next += static_cast<uint16_t>(f.seq - kStream.seq(s->next));
+    if (++s->calls % 2000 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  while (s->next < s->packets && lost_on_both(s->next, s->packets)) ++s->next;
+  if (!kStream.intact(f, s->next, kStream.packet(s->next, kPayloadBytes))) ++s->bad_payload;
+  ++s->next;
+  s->rx->release_slab(f.slab_idx);
+}
+
+bool run(const char *name, size_t packets, size_t skew, bool stall = false) {
+  rtp::Receiver rx;
+  if (stall) {
+    rtp::Receiver::Capacity c;
+    c.slabs = 1024;  // the smallest pool: a stall exhausts the lanes' partitions
+    rx.set_capacity(c);
+  }
+  rx.set_recv_buf_size(8 << 20);
+  // Stalled: full batches, so a batch taken with the partition exhausted is all busy.
+  rx.set_recv_batch(16, stall ? 2000 : 0);
+  rx.set_jitter_depth(512);
+  rx.set_redundant_path("127.0.0.1", kPort1);
+  Sink sink;
+  sink.rx      = &rx;
+  sink.packets = packets;
+  sink.stall   = stall;
+  if (!rx.start("127.0.0.1", kPort0, &sink, on_packet)) {
+    std::printf("%s: start failed\n", name);
+    return false;
+  }
+  // Both lane threads up before the first packet: a path whose thread starts late would
+  // look like one trailing by the startup time.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  {
+    const rtp_test::Sender tx(kPort0);
+    const sockaddr_in path1 = rtp_test::loopback(kPort1);
+    // Path 1 sends packet i - skew alongside path 0's packet i.
+    for (size_t i = 0; i < packets + skew; ++i) {
+      if (i < packets && !lost_on_path0(i, packets)) tx.send(kStream.packet(i, kPayloadBytes));
+      if (i >= skew && !lost_on_path1(i - skew, packets))
+        tx.send(kStream.packet(i - skew, kPayloadBytes), path1);
+      if (i % 64 == 63) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  rx.stop();
+
+  size_t both = 0, lost0 = 0, lost1 = 0;
+  for (size_t i = 0; i < packets; ++i) {
+    both += lost_on_both(i, packets);
+    lost0 += lost_on_path0(i, packets);
+    lost1 += lost_on_path1(i, packets);
+  }
+  size_t order_errors = 0;
+  size_t i            = 0;
+  uint16_t prev       = 0;
+  for (const uint16_t seq : sink.seqs) {
+    if (stall) {
+      // Busy drops leave gaps: only a step back is out of order.
+      order_errors += i++ > 0 && static_cast<int16_t>(seq - prev) <= 0;
+      prev = seq;
+      continue;
+    }
+    while (i < packets && lost_on_both(i, packets)) ++i;
+    if (seq != kStream.seq(i)) ++order_errors;
+    ++i;
+  }
+
+  // A path's own counters see every datagram the socket took, busy-dropped or not.
+  const bool paths = rx.path_lost(0) == lost0 && rx.path_lost(1) == lost1
+                     && rx.path_packets(0) == packets - lost0 && rx.path_packets(1) == packets - lost1;
+  const bool delivered = order_errors == 0
+                         && (stall ? rx.slot_busy_drops() > 0
+                                   : sink.seqs.size() == packets - both && rx.net_lost_packets() == both
+                                         && (skew == 0 || rx.path_skew_us() > 0));
+  const bool ok = paths && delivered && sink.bad_payload == 0;
+  std::printf("%s: delivered %zu/%zu (order errors %zu, bad payload %zu), net %zu/%zu, busy %zu, path 0 lost "
+              "%zu/%zu pkts %zu, path 1 lost %zu/%zu pkts %zu, skew %lld us (max %lld) -> %s\n",
+              name, sink.seqs.size(), packets - both, order_errors, sink.bad_payload, rx.net_lost_packets(), both,
+              rx.slot_busy_drops(), rx.path_lost(0), lost0, rx.path_packets(0), rx.path_lost(1), lost1,
+              rx.path_packets(1), static_cast<long long>(rx.path_skew_us()),
+              static_cast<long long>(rx.path_skew_max_us()), ok ? "PASS" : "FAIL");
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const size_t packets = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+  bool ok              = run("aligned", packets, 0);
+  ok                   = run("skewed", packets, kSkewPackets) && ok;
+  ok                   = run("stalled", packets, 0, true) && ok;
+  std::printf(ok ? "ALL PASS\n" : "FAILED\n");
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,163 @@
+// fec_test — SMPTE 2022-1 FEC recovery in rtp::Receiver (set_fec).
+//
+// A sender protects a stream with an L x D parity matrix (2022-1 FEC header, XOR over
+// the RTP payload and the recoverable header fields), sending row parity after each row
+// and column parity after each matrix to two companion ports, and drops media packets in
+// patterns per matrix: one packet (row and column recover it), a whole row (each column
+// recovers one), an L-shape that only iterating rows and columns recovers, and a 2 x 2
+// square no parity can. Every packet outside the squares must reach the hook intact —
+// payload bytes, length, marker and timestamp — and in order; fec_recovered(),
+// fec_unrecoverable() and net_lost_packets() must match the pattern.
+//
+// usage: fec_test [matrices=200]
+// Exit status is non-zero on any mismatch.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "rtp_receiver.hpp"
+#include "rtp_test_sender.hpp"
+
+namespace {
+
+constexpr uint16_t kMediaPort  = 47300;
+constexpr uint16_t kColumnPort = kMediaPort + 2;  // 2022-1 convention
+constexpr uint16_t kRowPort    = kMediaPort + 4;
+constexpr size_t kL            = 10;  // columns: packets per row
+constexpr size_t kD            = 5;   // rows
+constexpr size_t kMatrix       = kL * kD;
+// first_seq (wraps in the first matrices), ssrc, packets_per_ts, fill
+constexpr rtp_test::Stream kStream{65500, 0x2022, 40, 131};
+
+using Packet = std::vector<uint8_t>;  // RTP header + payload
+
+size_t payload_len(size_t i) { return 900 + (i * 37) % 500; }
+Packet media(size_t i) { return kStream.packet(i, payload_len(i)); }
+
+// 2022-1 parity over media packets first, first + offset, ... (count of them).
+Packet parity(size_t first, size_t offset, size_t count, bool row, uint16_t fec_seq) {
+  size_t longest = 0;
+  for (size_t k = 0; k < count; ++k) longest = std::max(longest, payload_len(first + k * offset));
+  Packet p(12 + 16 + longest, 0);
+  uint8_t *h       = &p[12];
+  uint16_t len_rec = 0;
+  uint8_t pt_rec   = 0;
+  uint32_t ts_rec  = 0;
+  for (size_t k = 0; k < count; ++k) {
+    const Packet m = media(first + k * offset);
+    p[0]   = static_cast<uint8_t>(p[0] ^ (m[0] & 0x3F));
+    p[1]   = static_cast<uint8_t>(p[1] ^ (m[1] & 0x80));
+    pt_rec = static_cast<uint8_t>(pt_rec ^ (m[1] & 0x7F));
+    len_rec ^= static_cast<uint16_t>(m.size() - 12);
+    uint32_t ts;
+    std::memcpy(&ts, &m[4], 4);
+    ts_rec ^= ntohl(ts);
+    for (size_t b = 12; b < m.size(); ++b) h[16 + b - 12] ^= m[b];
+  }
+  p[0] |= 0x80;
+  p[1] |= 96;
+  p[2]                  = static_cast<uint8_t>(fec_seq >> 8);
+  p[3]                  = static_cast<uint8_t>(fec_seq);
+  const uint16_t base   = static_cast<uint16_t>(kStream.first_seq + first);
+  h[0]                  = static_cast<uint8_t>(base >> 8);
+  h[1]                  = static_cast<uint8_t>(base);
+  h[2]                  = static_cast<uint8_t>(len_rec >> 8);
+  h[3]                  = static_cast<uint8_t>(len_rec);
+  h[4]                  = pt_rec;
+  const uint32_t ts_net = htonl(ts_rec);
+  std::memcpy(h + 8, &ts_net, 4);
+  h[12] = static_cast<uint8_t>(row ? 0x40 : 0);  // D bit; type 0 = XOR
+  h[13] = static_cast<uint8_t>(offset);
+  h[14] = static_cast<uint8_t>(count);
+  return p;
+}
+
+// Media packet `i` dropped by the network.
+bool dropped(size_t i, size_t matrices) {
+  const size_t m = i / kMatrix;
+  const size_t r = (i % kMatrix) / kL;
+  const size_t c = i % kL;
+  if (m == 0 || rtp_test::clean_tail(i, matrices * kMatrix)) return false;
+  switch (m % 4) {
+    case 0: return (r == 1 && (c == 2 || c == 6)) || (r == 3 && c == 2);  // L-shape
+    case 1: return r == 2 && c == 3;                                       // single
+    case 2: return r == 1;                                                 // whole row
+    default: return (r == 1 || r == 2) && (c == 4 || c == 5);            // square
+  }
+}
+bool unrecoverable(size_t i, size_t matrices) { return dropped(i, matrices) && (i / kMatrix) % 4 == 3; }
+
+struct Sink {
+  rtp::Receiver *rx = nullptr;
+  size_t matrices   = 0;
+  size_t next       = 0;  // next media index expected at the hook
+  size_t delivered  = 0;
+  size_t errors     = 0;
+};
+
+void on_packet(void *arg, const rtp::Frame &f) {
+  auto *s = static_cast<Sink *>(arg);
+  while (s->next < s->matrices * kMatrix && unrecoverable(s->next, s->matrices)) ++s->next;
+  if (!kStream.intact(f, s->next, media(s->next)) && s->errors++ < 5)
+    std::printf("mismatch at media packet %zu (seq %u)\n", s->next, f.seq);
+  ++s->next;
+  ++s->delivered;
+  s->rx->release_slab(f.slab_idx);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const size_t matrices = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+  rtp::Receiver rx;
+  rx.set_recv_buf_size(8 << 20);
+  rx.set_jitter_depth(256);  // > a matrix plus its column parity
+  rx.set_fec(kColumnPort, kRowPort);
+  Sink sink;
+  sink.rx       = &rx;
+  sink.matrices = matrices;
+  if (!rx.start("127.0.0.1", kMediaPort, &sink, on_packet)) {
+    std::printf("start failed\n");
+    return EXIT_FAILURE;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));  // FEC thread up
+
+  const rtp_test::Sender tx(kMediaPort);
+  const sockaddr_in row_dst    = rtp_test::loopback(kRowPort);
+  const sockaddr_in column_dst = rtp_test::loopback(kColumnPort);
+  size_t lost = 0, lost_for_good = 0;
+  uint16_t fec_seq = 0;
+  for (size_t m = 0; m < matrices; ++m) {
+    for (size_t r = 0; r < kD; ++r) {
+      for (size_t c = 0; c < kL; ++c) {
+        const size_t i = m * kMatrix + r * kL + c;
+        if (dropped(i, matrices)) {
+          ++lost;
+          lost_for_good += unrecoverable(i, matrices);
+          continue;
+        }
+        tx.send(media(i));
+      }
+      tx.send(parity(m * kMatrix + r * kL, 1, kL, true, fec_seq++), row_dst);
+    }
+    for (size_t c = 0; c < kL; ++c) tx.send(parity(m * kMatrix + c, kL, kD, false, fec_seq++), column_dst);
+    std::this_thread::sleep_for(std::chrono::microseconds(300));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  rx.stop();
+
+  const size_t expect = matrices * kMatrix - lost_for_good;
+  const bool ok = sink.errors == 0 && sink.delivered == expect && rx.fec_recovered() == lost - lost_for_good
+                  && rx.fec_unrecoverable() == lost_for_good && rx.net_lost_packets() == lost_for_good
+                  && rx.fec_packets() == matrices * (kL + kD);
+  std::printf("delivered %zu/%zu (mismatches %zu), dropped %zu: recovered %zu/%zu, unrecoverable %zu/%zu, "
+              "net %zu, parity %zu/%zu -> %s\n",
+              sink.delivered, expect, sink.errors, lost, rx.fec_recovered(), lost - lost_for_good,
+              rx.fec_unrecoverable(), lost_for_good, rx.net_lost_packets(), rx.fec_packets(), matrices * (kL + kD),
+              ok ? "PASS" : "FAIL");
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,6 +1,6 @@
 // incremental_delivery_test — contract test for frame_handler's incremental
 // (sub-frame) delivery: the chunk callback, the frame-abort callback, and the
-// pull_data `gap` parameter.
+// pull_data `gap` and `new_timestamp` parameters.
 //
 // Feeds a real codestream through frame_handler as RFC 9828-shaped packets
 // ([8B sub-header][J2K bytes], the post-RTP-header form pull_data takes) and
@@ -14,6 +14,11 @@
 //                when the next frame's main packet arrives; the next frame is clean.
 //   EOC gap    — losing the packet(s) right before the EOC packet aborts the frame
 //                (kAbortGap) and never fires frame_ready for it.
+//   bulk release — with the release-through callback set, a clean, a gapped and a
+//                cut frame each go back in one forward-moving call, nothing leaked.
+//   dead frames — a gapped frame holds no slabs past the gap, and a frame whose EOC
+//                was lost is closed by the next packet's new timestamp, even when the
+//                next frame's main packet is lost too.
 //
 // With a SECOND stream of DIFFERENT geometry (different image size — the hatch scenario
 // needs the structures to actually disagree), the stream re-latch scenarios run too:
@@ -127,7 +132,7 @@ void on_abort(void *u, int reason) {
   c->dead = true;
 }
 
-void on_ready(void *u, const codestream &, bool intact) {
+void on_ready(void *u, const codestream &, bool intact, uint32_t) {
   auto *c = static_cast<Ctx *>(u);
   c->frames_ready++;
   if (intact) c->frames_intact++;
@@ -142,6 +147,9 @@ void on_relatch(void *u, int reason) {
 struct Slabs {
   std::vector<std::vector<uint8_t>> mem;
   std::vector<int> held;
+  size_t through       = 0;  // release_through: every index below this is released
+  size_t through_calls = 0;
+  bool through_back    = false;
   size_t leaked() const {
     size_t n = 0;
     for (int h : held) n += (h != 0);
@@ -154,6 +162,15 @@ void release_slab(void *u, size_t idx) {
   if (idx < s->held.size()) s->held[idx] = 0;
 }
 
+// Bulk release: the arena index follows delivery order, as a receiver's generations do.
+void release_through(void *u, size_t idx) {
+  auto *s = static_cast<Slabs *>(u);
+  if (idx < s->through) s->through_back = true;
+  for (size_t i = s->through; i <= idx && i < s->held.size(); i++) s->held[i] = 0;
+  if (idx + 1 > s->through) s->through = idx + 1;
+  s->through_calls++;
+}
+
 int fails = 0;
 #define CHECK(cond, ...)                          \
   do {                                            \
@@ -164,11 +181,13 @@ int fails = 0;
     }                                             \
   } while (0)
 
-// Feed a packet list; skip[i]==true drops packet i (gap=true passed on the next
-// delivered packet, like the receiver's force-advance does).
+// Feed a packet list as one RTP timestamp; skip[i]==true drops packet i (gap=true
+// passed on the next delivered packet, like the receiver's force-advance does). The
+// first delivered packet carries new_timestamp, as rtp::Receiver flags it.
 void feed(j2k::frame_handler &fh, Slabs &slabs, const std::vector<Pkt> &pkts,
           const std::vector<bool> *skip = nullptr) {
   bool pending_gap = false;
+  bool first       = true;
   for (size_t i = 0; i < pkts.size(); i++) {
     if (skip && (*skip)[i]) {
       pending_gap = true;
@@ -177,8 +196,9 @@ void feed(j2k::frame_handler &fh, Slabs &slabs, const std::vector<Pkt> &pkts,
     size_t idx = slabs.mem.size();
     slabs.mem.push_back(pkts[i].payload);  // slab-lifetime copy
     slabs.held.push_back(1);
-    fh.pull_data(slabs.mem[idx].data(), pkts[i].payload.size() - 8, pkts[i].marker, idx, pending_gap);
+    fh.pull_data(slabs.mem[idx].data(), pkts[i].payload.size() - 8, pkts[i].marker, idx, pending_gap, first);
     pending_gap = false;
+    first       = false;
   }
 }
 
@@ -283,7 +303,60 @@ int main(int argc, char **argv) {
     CHECK(slabs.leaked() == 0, "eoc-gap: %zu slabs leaked\n", slabs.leaked());
   }
 
-  int scenarios = 4;
+  // ---- scenario 5: bulk release (clean, gapped, cut frame, then a clean one) ----
+  {
+    j2k::frame_handler fh;
+    Ctx ctx;
+    Slabs slabs;
+    fh.set_release_slab_callback(&release_slab, &slabs);
+    fh.set_release_through_callback(&release_through, &slabs);
+    fh.set_chunk_callback(&on_chunk, &ctx);
+    fh.set_frame_abort_callback(&on_abort, &ctx);
+    fh.set_frame_ready_callback(&on_ready, &ctx);
+    feed(fh, slabs, pkts);
+    std::vector<bool> skip(pkts.size(), false);
+    skip[pkts.size() / 2] = true;
+    feed(fh, slabs, pkts, &skip);
+    std::vector<Pkt> cut(pkts.begin(), pkts.end() - 3);
+    feed(fh, slabs, cut);
+    feed(fh, slabs, pkts);
+    CHECK(ctx.frames_ready == 2 && ctx.frames_intact == 2, "bulk: %zu frames ready, 2 expected\n",
+          ctx.frames_ready);
+    CHECK(slabs.through_calls == 4, "bulk: %zu release-through calls, 4 expected\n", slabs.through_calls);
+    CHECK(!slabs.through_back, "bulk: release-through moved backwards\n");
+    CHECK(slabs.leaked() == 0, "bulk: %zu slabs leaked\n", slabs.leaked());
+  }
+
+  // ---- scenario 6: dead frames let go at once ----
+  {
+    j2k::frame_handler fh;
+    Ctx ctx;
+    Slabs slabs;
+    fh.set_release_slab_callback(&release_slab, &slabs);
+    fh.set_chunk_callback(&on_chunk, &ctx);
+    fh.set_frame_abort_callback(&on_abort, &ctx);
+    fh.set_frame_ready_callback(&on_ready, &ctx);
+    std::vector<Pkt> gapped(pkts.begin(), pkts.begin() + static_cast<long>(pkts.size() / 2 + 2));
+    std::vector<bool> skip(gapped.size(), false);
+    skip[pkts.size() / 2] = true;  // the frame's tail has not arrived yet
+    feed(fh, slabs, gapped, &skip);
+    CHECK(slabs.leaked() == 0, "dead: gapped frame still holds %zu slabs\n", slabs.leaked());
+    std::vector<Pkt> cut(pkts.begin(), pkts.end() - 3);
+    feed(fh, slabs, cut);  // closes the gapped frame; loses its own EOC
+    std::vector<Pkt> headless(pkts.begin() + 1, pkts.end());
+    feed(fh, slabs, headless);  // main packet lost too: only the timestamp closes the cut frame
+    CHECK(ctx.aborts.size() == 2 && ctx.aborts[0] == j2k::frame_handler::kAbortGap
+              && ctx.aborts[1] == j2k::frame_handler::kAbortMissedEOC,
+          "dead: expected kAbortGap then kAbortMissedEOC, got %zu aborts\n", ctx.aborts.size());
+    CHECK(slabs.leaked() == 0, "dead: %zu slabs held after the cut frame was closed\n", slabs.leaked());
+    CHECK(fh.get_trunc_frames() == 2 && fh.get_total_frames() == 2, "dead: trunc=%zu total=%zu != 2/2\n",
+          fh.get_trunc_frames(), fh.get_total_frames());
+    feed(fh, slabs, pkts);
+    CHECK(ctx.got == cs && ctx.frames_ready == 1 && ctx.frames_intact == 1, "dead: next frame not clean\n");
+    CHECK(slabs.leaked() == 0, "dead: %zu slabs leaked\n", slabs.leaked());
+  }
+
+  int scenarios = 6;
 
   // ---- stream re-latch scenarios (need a second, different-geometry stream) ----
   std::vector<uint8_t> csB;
@@ -302,7 +375,7 @@ int main(int argc, char **argv) {
     std::printf("stream %s: %zu B -> %zu packets\n", argv[2], csB.size(), pktsB.size());
   }
 
-  // ---- scenario 5: geometry re-latch — A, B, B, A, all clean ----
+  // ---- scenario 7: geometry re-latch — A, B, B, A, all clean ----
   if (!pktsB.empty()) {
     j2k::frame_handler fh;
     Ctx ctx;
@@ -332,7 +405,7 @@ int main(int argc, char **argv) {
     scenarios++;
   }
 
-  // ---- scenario 6: mid-stream flip on a torn frame (the 2026-07-14 field shape) ----
+  // ---- scenario 8: mid-stream flip on a torn frame (the 2026-07-14 field shape) ----
   if (!pktsB.empty()) {
     j2k::frame_handler fh;
     Ctx ctx;
@@ -357,7 +430,7 @@ int main(int argc, char **argv) {
     scenarios++;
   }
 
-  // ---- scenario 7: parse-fail escape hatch — hybrid frames (A header + B body) ----
+  // ---- scenario 9: parse-fail escape hatch — hybrid frames (A header + B body) ----
   if (!pktsB.empty()) {
     j2k::frame_handler fh;
     Ctx ctx;
@@ -384,7 +457,7 @@ int main(int argc, char **argv) {
     scenarios++;
   }
 
-  // ---- scenario 8: rate-only exemption — same geometry, different rate, NO re-latch ----
+  // ---- scenario 10: rate-only exemption — same geometry, different rate, NO re-latch ----
   if (argc >= 4) {
     std::vector<uint8_t> csC = read_file(argv[3]);
     if (csC.size() < 4 || csC[0] != 0xFF || csC[1] != 0x4F) {
@@ -0,0 +1,200 @@
+// ingest_bench — loopback throughput benchmark for rtp::Receiver's ingest paths.
+//
+// A sender thread blasts RTP-shaped datagrams (RFC 3550 header + zero payload,
+// consecutive sequence numbers) at 127.0.0.1 using UDP GSO (UDP_SEGMENT): each send()
+// carries up to 64 KB, segmented by the kernel into pkt_bytes datagrams. The receiver's
+// hook counts packets and releases the slab at once, so the number is the ingest path's
+// ceiling, not the parser's. Per scenario it prints delivered packets/s, receive calls/s,
+// the average datagrams per call and the net-loss / slot-busy drop counters:
+//   socket     — one recv() per datagram (the kernel segments GSO sends for us)
+//   batch32    — recvmmsg(), 32 per call
+//   gro        — UDP_GRO: one recvmsg() per coalesced super-datagram
+//   reuse2     — two SO_REUSEPORT sockets, recvmmsg() 32 per call, merged in order.
+//                The socket is picked per GSO send (before segmentation), so each lane
+//                sees whole bursts here rather than alternate packets as on a real NIC.
+//   tcp        — the same packets RFC 4571-framed over a loopback TCP connection; the
+//                receiver reads 512 KB per call and skips the jitter ring.
+//   packet_ring — AF_PACKET TPACKET_V3 ring on lo. The sender sends datagram by datagram
+//                here: lo passes a GSO send up unsegmented, so the ring would see one
+//                64 KB packet. "calls" are ring blocks walked. Needs CAP_NET_RAW;
+//                skipped without it.
+//   uring      — io_uring multishot recv into the slab buffer ring; "calls" are
+//                completion batches reaped. Needs Linux 6.0+; skipped on older kernels.
+//   uring_stall — uring with a hook that stops for 50 ms every 100000 packets. The queued
+//                jobs then hold the whole pool, so the multishot recv ends on ENOBUFS, the
+//                recv thread drains the socket into scratch (busy=) and re-arms once the
+//                worker catches up; pkt/s shows what the stalls cost.
+//
+// usage: ingest_bench [seconds_per_scenario=2] [pkt_bytes=1400]
+// On a single-core box sender and receiver share the CPU; compare scenarios, not
+// absolute numbers.
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rtp_receiver.hpp"
+#include "rtp_test_sender.hpp"
+
+namespace {
+
+constexpr uint16_t kPort = 47100;
+
+struct Counter {
+  rtp::Receiver *rx = nullptr;
+  bool stall        = false;
+  std::atomic<size_t> packets{0};
+};
+
+void count_hook(void *arg, const rtp::Frame &f) {
+  auto *c        = static_cast<Counter *>(arg);
+  const size_t n = c->packets.fetch_add(1, std::memory_order_relaxed);
+  c->rx->release_slab(f.slab_idx);
+  if (c->stall && n % 100000 == 99999) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
+// Sends GSO bursts of `pkt_bytes` datagrams until `stop` is set; with !gso, the same
+// bursts one datagram per send.
+void sender(std::atomic<bool> *stop, size_t pkt_bytes, bool gso) {
+  int fd  = ::socket(AF_INET, SOCK_DGRAM, 0);
+  int seg = static_cast<int>(pkt_bytes);
+  if (gso && ::setsockopt(fd, IPPROTO_UDP, UDP_SEGMENT, &seg, sizeof(seg)) < 0) {
+    std::perror("setsockopt(UDP_SEGMENT)");
+    ::close(fd);
+    return;
+  }
+  sockaddr_in dst{};
+  dst.sin_family = AF_INET;
+  dst.sin_port   = htons(kPort);
+  ::inet_pton(AF_INET, "127.0.0.1", &dst.sin_addr);
+
+  const size_t per_send = 60000 / pkt_bytes;  // stay under the 64 KB GSO limit
+  std::vector<uint8_t> buf(per_send * pkt_bytes, 0);
+  uint16_t seq = 0;
+  while (!stop->load(std::memory_order_relaxed)) {
+    for (size_t k = 0; k < per_send; ++k) {
+      uint8_t *p = buf.data() + k * pkt_bytes;
+      p[0]       = 0x80;
+      p[1]       = 96;
+      p[2]       = static_cast<uint8_t>(seq >> 8);
+      p[3]       = static_cast<uint8_t>(seq);
+      ++seq;
+    }
+    if (gso) {
+      ::sendto(fd, buf.data(), buf.size(), 0, reinterpret_cast<sockaddr *>(&dst), sizeof(dst));
+      continue;
+    }
+    for (size_t k = 0; k < per_send; ++k)
+      ::sendto(fd, buf.data() + k * pkt_bytes, pkt_bytes, 0, reinterpret_cast<sockaddr *>(&dst), sizeof(dst));
+  }
+  ::close(fd);
+}
+
+// Streams RFC 4571-framed `pkt_bytes` packets over TCP until `stop` is set.
+void tcp_sender(std::atomic<bool> *stop, size_t pkt_bytes, bool) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in dst{};
+  dst.sin_family = AF_INET;
+  dst.sin_port   = htons(kPort);
+  ::inet_pton(AF_INET, "127.0.0.1", &dst.sin_addr);
+  if (::connect(fd, reinterpret_cast<sockaddr *>(&dst), sizeof(dst)) < 0) {
+    std::perror("connect");
+    ::close(fd);
+    return;
+  }
+  const size_t frame    = 2 + pkt_bytes;
+  const size_t per_send = 60000 / frame;
+  std::vector<uint8_t> buf(per_send * frame, 0);
+  uint16_t seq = 0;
+  while (!stop->load(std::memory_order_relaxed)) {
+    for (size_t k = 0; k < per_send; ++k) {
+      uint8_t *p = buf.data() + k * frame;
+      p[0]       = static_cast<uint8_t>(pkt_bytes >> 8);
+      p[1]       = static_cast<uint8_t>(pkt_bytes);
+      p[2]       = 0x80;
+      p[3]       = 96;
+      p[4]       = static_cast<uint8_t>(seq >> 8);
+      p[5]       = static_cast<uint8_t>(seq);
+      ++seq;
+    }
+    for (size_t off = 0; off < buf.size() && !stop->load(std::memory_order_relaxed);) {
+      const ssize_t n = ::send(fd, buf.data() + off, buf.size() - off, MSG_NOSIGNAL);
+      if (n <= 0) break;
+      off += static_cast<size_t>(n);
+    }
+  }
+  ::close(fd);
+}
+
+void run(const char *name, double seconds, size_t pkt_bytes, size_t batch, bool gro, size_t sockets = 1,
+         rtp::Receiver::Ingest ingest = rtp::Receiver::Ingest::kSocket, bool stall = false) {
+  rtp::Receiver rx;
+  rx.set_recv_buf_size(32 * 1024 * 1024);
+  rx.set_recv_batch(batch);
+  rx.set_udp_gro(gro);
+  rx.set_recv_sockets(sockets);
+  rx.set_ingest(ingest);
+  Counter c;
+  c.rx    = &rx;
+  c.stall = stall;
+  if (!rx.start("127.0.0.1", kPort, &c, count_hook)) {
+    std::fprintf(stderr, "%s: receiver start failed\n", name);
+    return;
+  }
+  std::atomic<bool> stop{false};
+  const bool tcp = ingest == rtp::Receiver::Ingest::kTcp;
+  std::thread tx(tcp ? tcp_sender : sender, &stop, pkt_bytes, ingest != rtp::Receiver::Ingest::kPacketRing);
+  const auto t0 = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  const size_t pkts  = c.packets.load();
+  const size_t calls = rx.recv_calls();
+  const size_t dgram = rx.recv_datagrams();
+  const double dt    = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  stop.store(true);
+  tx.join();
+  rx.stop();
+  std::printf("%-11s %10.0f pkt/s  %9.0f calls/s  %6.1f dgrams/call  %7.1f Mbps  net_lost=%zu  busy=%zu\n",
+              name, static_cast<double>(pkts) / dt, static_cast<double>(calls) / dt,
+              calls ? static_cast<double>(dgram) / static_cast<double>(calls) : 0.0,
+              static_cast<double>(pkts) * static_cast<double>(pkt_bytes) * 8.0 / dt / 1e6,
+              rx.net_lost_packets(), rx.slot_busy_drops());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const double seconds   = argc > 1 ? std::atof(argv[1]) : 2.0;
+  const size_t pkt_bytes = argc > 2 ? static_cast<size_t>(std::atoi(argv[2])) : 1400;
+  if (pkt_bytes < 12 || pkt_bytes > 9000) {
+    std::fprintf(stderr, "pkt_bytes must be in [12, 9000]\n");
+    return 2;
+  }
+  std::printf("loopback ingest, %zu-byte RTP datagrams, %.1f s per scenario\n", pkt_bytes, seconds);
+  run("socket", seconds, pkt_bytes, 1, false);
+  run("batch32", seconds, pkt_bytes, 32, false);
+  run("gro", seconds, pkt_bytes, 1, true);
+  run("reuse2", seconds, pkt_bytes, 32, false, 2);
+  run("tcp", seconds, pkt_bytes, 1, false, 1, rtp::Receiver::Ingest::kTcp);
+  if (rtp_test::can_packet_ring()) {
+    run("packet_ring", seconds, pkt_bytes, 1, false, 1, rtp::Receiver::Ingest::kPacketRing);
+  } else {
+    std::printf("packet_ring skipped (AF_PACKET needs CAP_NET_RAW)\n");
+  }
+  if (rtp_test::kernel_at_least(6, 0)) {
+    run("uring", seconds, pkt_bytes, 1, false, 1, rtp::Receiver::Ingest::kIoUring);
+    run("uring_stall", seconds, pkt_bytes, 1, false, 1, rtp::Receiver::Ingest::kIoUring, true);
+  } else {
+    std::printf("uring skipped (multishot recv needs Linux 6.0+)\n");
+  }
+  return 0;
+}
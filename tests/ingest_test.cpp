@@ -0,0 +1,117 @@
+// ingest_test — delivery through rtp::Receiver's alternative ingest backends (set_ingest)
+// on loopback.
+//
+// A paced stand-in sender (rtp_test_sender.hpp) streams RTP packets of varying length to
+// 127.0.0.1. Every packet must reach the hook intact and in order, and net_lost_packets()
+// and slot_busy_drops() must stay 0. Backends:
+//   packet_ring — AF_PACKET TPACKET_V3 ring on lo, which also sees each datagram as
+//                 PACKET_OUTGOING. Needs CAP_NET_RAW; skipped, with a message, without it.
+//   uring       — io_uring multishot recv into the slab buffer ring. Needs Linux 6.0+;
+//                 skipped, with a message, on older kernels.
+//   uring_stall — uring on the smallest pool, with a hook that stops for 60 ms every 2000
+//                 packets in the first part of the run. The queued jobs then hold the whole
+//                 pool: the multishot recv ends on ENOBUFS, the recv thread drains the
+//                 socket into scratch (counted busy) and re-arms once the worker frees
+//                 slabs. What is delivered must be intact and in order, there must have
+//                 been busy drops, and every packet of the loss-free tail must arrive.
+//
+// usage: ingest_test [packets=20000]
+// Exit status is non-zero on any mismatch; a skipped backend is not a failure.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "rtp_receiver.hpp"
+#include "rtp_test_sender.hpp"
+
+namespace {
+
+constexpr uint16_t kPort = 47700;
+// first_seq (wraps early in the run), ssrc, packets_per_ts, fill
+constexpr rtp_test::Stream kStream{65000, 0x4571, 100, 43};
+
+size_t payload_len(size_t i) { return 600 + (i * 71) % 800; }
+std::vector<uint8_t> media(size_t i) { return kStream.packet(i, payload_len(i)); }
+
+struct Sink {
+  rtp::Receiver *rx = nullptr;
+  size_t packets    = 0;
+  bool stall        = false;
+  size_t next       = 0;  // next index expected at the hook
+  size_t delivered  = 0;
+  size_t tail       = 0;  // delivered from the loss-free tail
+  size_t errors     = 0;
+};
+
+void on_packet(void *arg, const rtp::Frame &f) {
+  auto *s = static_cast<Sink *>(arg);
+  // Stalled: stretches are dropped busy, so follow the sequence number forward.
+  if (s->stall) s->next += static_cast<uint16_t>(f.seq - kStream.seq(s->next));
+  if (!kStream.intact(f, s->next, media(s->next)) && s->errors++ < 5)
+    std::printf("  mismatch at packet %zu (seq %u)\n", s->next, f.seq);
+  s->tail += rtp_test::clean_tail(s->next, s->packets);
+  ++s->next;
+  ++s->delivered;
+  s->rx->release_slab(f.slab_idx);
+  if (s->stall && s->delivered % 2000 == 0 && !rtp_test::clean_tail(s->next + rtp_test::kCleanTail, s->packets))
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+}
+
+bool run(const char *name, rtp::Receiver::Ingest ingest, size_t packets, bool stall = false) {
+  rtp::Receiver rx;
+  rx.set_recv_buf_size(8 << 20);
+  rx.set_ingest(ingest);
+  if (stall) {
+    rtp::Receiver::Capacity c;
+    c.slabs = 1024;  // the smallest pool: a stall's backlog outgrows it
+    rx.set_capacity(c);
+  }
+  Sink sink;
+  sink.rx      = &rx;
+  sink.packets = packets;
+  sink.stall   = stall;
+  if (!rx.start("127.0.0.1", kPort, &sink, on_packet)) {
+    std::printf("%s: start failed -> FAIL\n", name);
+    return false;
+  }
+  {
+    const rtp_test::Sender tx(kPort);
+    for (size_t i = 0; i < packets; ++i) {
+      tx.send(media(i));
+      rtp_test::Sender::pace(i);
+    }
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  rx.stop();
+
+  const size_t tail = std::min(packets, rtp_test::kCleanTail);
+  const bool ok     = sink.errors == 0 && sink.tail == tail
+                  && (stall ? rx.slot_busy_drops() > 0
+                            : sink.delivered == packets && rx.net_lost_packets() == 0 && rx.slot_busy_drops() == 0);
+  std::printf("%s: delivered %zu/%zu (mismatches %zu), tail %zu/%zu, net %zu, busy %zu -> %s\n", name,
+              sink.delivered, packets, sink.errors, sink.tail, tail, rx.net_lost_packets(), rx.slot_busy_drops(),
+              ok ? "PASS" : "FAIL");
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const size_t packets = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+  bool ok              = true;
+  if (rtp_test::can_packet_ring()) {
+    ok = run("packet_ring", rtp::Receiver::Ingest::kPacketRing, packets) && ok;
+  } else {
+    std::printf("packet_ring: skipped (AF_PACKET needs CAP_NET_RAW)\n");
+  }
+  if (rtp_test::kernel_at_least(6, 0)) {
+    ok = run("uring", rtp::Receiver::Ingest::kIoUring, packets) && ok;
+    ok = run("uring_stall", rtp::Receiver::Ingest::kIoUring, packets, true) && ok;
+  } else {
+    std::printf("uring: skipped (multishot recv needs Linux 6.0+)\n");
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,186 @@
+// nack_test — RFC 4585 NACK / RFC 4588 retransmission in rtp::Receiver (set_retransmission).
+//
+// A stand-in sender streams RTP to the receiver, dropping single packets and short bursts,
+// and answers the receiver's RTCP NACKs from a thread of its own with RTX packets (own
+// SSRC and sequence numbers, payload type kRtxPt, original sequence number in front of the
+// payload) sent to the media port. It ignores the first request for some packets, so only
+// the repeat brings them back, and never retransmits others. The jitter depth is far
+// below the deadline in packets, so every recovered packet is one the ring held for.
+// Every packet but the refused ones must reach the hook intact and in order;
+// nack_requested() must count each dropped packet once, rtx_recovered() the answered
+// ones, and nack_expired() and net_lost_packets() exactly the refused ones.
+//
+// usage: nack_test [packets=30000]
+// Exit status is non-zero on any mismatch.
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "rtp_receiver.hpp"
+#include "rtp_test_sender.hpp"
+
+namespace {
+
+constexpr uint16_t kMediaPort = 47400;
+constexpr uint16_t kNackPort  = 47401;  // the stand-in sender's RTCP port
+constexpr uint8_t kRtxPt      = 97;
+constexpr uint32_t kRtxSsrc   = 0x4588;
+constexpr double kDeadlineMs  = 20;
+// first_seq (wraps early in the run), ssrc, packets_per_ts, fill
+constexpr rtp_test::Stream kStream{60000, 0x4585, 100, 31};
+
+size_t payload_len(size_t i) { return 800 + (i * 53) % 600; }
+std::vector<uint8_t> media(size_t i) { return kStream.packet(i, payload_len(i)); }
+
+// Media packet `i` dropped on its first transmission: scattered singles and, every 2000
+// packets, a burst of 6.
+bool dropped(size_t i, size_t packets) {
+  if (i < 100 || rtp_test::clean_tail(i, packets)) return false;
+  return i % 97 == 13 || i % 2000 - 1500 < 6;
+}
+// Never retransmitted / retransmitted only when asked twice.
+bool refused(size_t i, size_t packets) { return dropped(i, packets) && i % 7 == 0; }
+bool second_ask(size_t i, size_t packets) { return dropped(i, packets) && i % 7 == 3; }
+
+struct Sink {
+  rtp::Receiver *rx = nullptr;
+  size_t packets    = 0;
+  size_t next       = 0;  // next media index expected at the hook
+  size_t delivered  = 0;
+  size_t errors     = 0;
+};
+
+void on_packet(void *arg, const rtp::Frame &f) {
+  auto *s = static_cast<Sink *>(arg);
+  while (s->next < s->packets && refused(s->next, s->packets)) ++s->next;
+  if (!kStream.intact(f, s->next, media(s->next)) && s->errors++ < 5)
+    std::printf("mismatch at media packet %zu (seq %u)\n", s->next, f.seq);
+  ++s->next;
+  ++s->delivered;
+  s->rx->release_slab(f.slab_idx);
+}
+
+// The stand-in sender's feedback side: reads generic NACKs on kNackPort and retransmits.
+struct Responder {
+  size_t packets = 0;
+  int fd         = -1;
+  std::atomic<bool> stop{false};
+  std::vector<uint8_t> asked;  // requests seen per media packet
+  size_t bad_feedback = 0;
+  uint16_t rtx_seq    = 0;
+
+  void retransmit(const rtp_test::Sender &out, size_t i) {
+    const std::vector<uint8_t> m = media(i);
+    std::vector<uint8_t> p(m.size() + 2);
+    std::memcpy(p.data(), m.data(), 12);
+    const uint32_t ssrc = htonl(kRtxSsrc);
+    p[1]                = static_cast<uint8_t>((m[1] & 0x80) | kRtxPt);
+    p[2]                = static_cast<uint8_t>(rtx_seq >> 8);
+    p[3]                = static_cast<uint8_t>(rtx_seq);
+    ++rtx_seq;
+    std::memcpy(&p[8], &ssrc, 4);
+    std::memcpy(&p[12], &m[2], 2);  // OSN
+    std::memcpy(&p[14], &m[12], m.size() - 12);
+    out.send(p);
+  }
+
+  void run() {
+    const rtp_test::Sender out(kMediaPort);
+    timeval tv{0, 20000};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    uint8_t buf[1500];
+    while (!stop.load()) {
+      const ssize_t r = ::recv(fd, buf, sizeof(buf), 0);
+      if (r < 0) continue;
+      uint32_t media_ssrc;
+      std::memcpy(&media_ssrc, buf + 8, 4);
+      const size_t words = (size_t{buf[2]} << 8 | buf[3]) + 1;
+      if (r < 16 || buf[0] != 0x81 || buf[1] != 205 || static_cast<size_t>(r) != 4 * words
+          || ntohl(media_ssrc) != kStream.ssrc) {
+        ++bad_feedback;
+        continue;
+      }
+      for (size_t off = 12; off < static_cast<size_t>(r); off += 4) {
+        const uint16_t pid = static_cast<uint16_t>(buf[off] << 8 | buf[off + 1]);
+        const uint16_t blp = static_cast<uint16_t>(buf[off + 2] << 8 | buf[off + 3]);
+        for (unsigned b = 0; b <= 16; ++b) {
+          if (b > 0 && !(blp & (1u << (b - 1)))) continue;
+          const size_t i = static_cast<uint16_t>(pid + b - kStream.first_seq);
+          if (i >= packets) {
+            ++bad_feedback;
+            continue;
+          }
+          const uint8_t n = ++asked[i];
+          if (refused(i, packets) || (second_ask(i, packets) && n < 2)) continue;
+          retransmit(out, i);
+        }
+      }
+    }
+  }
+};
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const size_t packets = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 30000;
+  Responder responder;
+  responder.packets = packets;
+  responder.asked.assign(packets, 0);
+  responder.fd         = ::socket(AF_INET, SOCK_DGRAM, 0);
+  const sockaddr_in fb = rtp_test::loopback(kNackPort);
+  if (::bind(responder.fd, reinterpret_cast<const sockaddr *>(&fb), sizeof(fb)) != 0) {
+    std::printf("bind %u failed\n", kNackPort);
+    return EXIT_FAILURE;
+  }
+  std::thread feedback([&responder] { responder.run(); });
+
+  rtp::Receiver rx;
+  rx.set_recv_buf_size(8 << 20);
+  rx.set_jitter_depth(32);  // far below the deadline's worth of packets
+  rx.set_retransmission("127.0.0.1", kNackPort, kRtxPt, kDeadlineMs);
+  Sink sink;
+  sink.rx      = &rx;
+  sink.packets = packets;
+  if (!rx.start("127.0.0.1", kMediaPort, &sink, on_packet)) {
+    std::printf("start failed\n");
+    responder.stop = true;
+    feedback.join();
+    return EXIT_FAILURE;
+  }
+
+  size_t lost = 0, lost_for_good = 0;
+  {
+    const rtp_test::Sender tx(kMediaPort);
+    for (size_t i = 0; i < packets; ++i) {
+      if (dropped(i, packets)) {
+        ++lost;
+        lost_for_good += refused(i, packets);
+      } else {
+        tx.send(media(i));
+      }
+      // ~100k packets/s: a 20 ms deadline spans ~2000 packets, inside the hold window.
+      rtp_test::Sender::pace(i);
+    }
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  rx.stop();
+  responder.stop = true;
+  feedback.join();
+  ::close(responder.fd);
+
+  const size_t expect = packets - lost_for_good;
+  const bool ok = sink.errors == 0 && sink.delivered == expect && responder.bad_feedback == 0
+                  && rx.nack_requested() == lost && rx.rtx_recovered() == lost - lost_for_good
+                  && rx.nack_expired() == lost_for_good && rx.net_lost_packets() == lost_for_good
+                  && rx.rtx_late() == 0;
+  std::printf("delivered %zu/%zu (mismatches %zu), dropped %zu: requested %zu/%zu, recovered %zu/%zu, "
+              "expired %zu/%zu, late %zu, net %zu, bad feedback %zu -> %s\n",
+              sink.delivered, expect, sink.errors, lost, rx.nack_requested(), lost, rx.rtx_recovered(),
+              lost - lost_for_good, rx.nack_expired(), lost_for_good, rx.rtx_late(), rx.net_lost_packets(),
+              responder.bad_feedback, ok ? "PASS" : "FAIL");
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -12,8 +12,13 @@
 //            whole codestream and assert (a) every precinct parses cleanly and
 //            (b) the precincts fire back, in order, identical to the built CRP walk.
 //            Exits non-zero on any failure.
+//   shed   : parse once to learn every precinct's byte offset, then re-walk the
+//            frame with each precinct start signaled (as ORDB packets would) and
+//            the highest resolution level shed: exactly the lower-level precincts
+//            must fire, in CRP order, and incomplete_levels() must name the shed
+//            level(s) only.
 //
-// Usage:  prcl_crp_test <codestream.j2c> [dump|parse]   (default: dump)
+// Usage:  prcl_crp_test <codestream.j2c> [dump|parse|shed]   (default: dump)
 //
 // This is test-harness wiring for the PRCL progression work; it touches no hot path.
 
@@ -47,15 +52,19 @@ std::vector<uint8_t> read_file(const char *path) {
 
 // Collects (c, r, p) triples fired by tile_handler's precinct-ready callback.
 std::vector<crp_status> g_parsed;
+// Byte offset where each fired precinct ended (shed mode: the next one's start).
+std::vector<uint32_t> g_ends;
+codestream *g_cs = nullptr;
 void on_precinct(void * /*user*/, const prec_ * /*pp*/, uint8_t c, uint8_t r, uint16_t p) {
   g_parsed.push_back({c, r, p});
+  if (g_cs) g_ends.push_back(static_cast<uint32_t>(g_cs->get_pos()));
 }
 
 }  // namespace
 
 int main(int argc, char **argv) {
   if (argc < 2) {
-    std::fprintf(stderr, "usage: %s <codestream.j2c> [dump|parse]\n", argv[0]);
+    std::fprintf(stderr, "usage: %s <codestream.j2c> [dump|parse|shed]\n", argv[0]);
     return 2;
   }
   const std::string mode = (argc > 2) ? argv[2] : "dump";
@@ -136,6 +145,71 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  std::fprintf(stderr, "error: unknown mode '%s' (want dump|parse)\n", mode.c_str());
+  if (mode == "shed") {
+    th.set_precinct_callback(on_precinct, nullptr);
+    g_cs = &cs;
+    if (th.flush() != EXIT_SUCCESS || g_parsed.size() != crp.size()) {
+      std::fprintf(stderr, "[FAIL] reference parse: %zu of %zu precincts\n", g_parsed.size(), crp.size());
+      return 1;
+    }
+    // Precinct i starts where i-1 ended; its PID is c + s*Csiz, s = its index among
+    // component c's precincts in CRP order.
+    std::vector<uint32_t> starts(crp.size());
+    std::vector<uint32_t> pids(crp.size());
+    uint32_t seen[MAX_NUM_COMPONENTS] = {};
+    for (size_t i = 0; i < crp.size(); ++i) {
+      starts[i] = i ? g_ends[i - 1] : start_SOD;
+      pids[i]   = crp[i].c + seen[crp[i].c]++ * siz->Csiz;
+    }
+
+    const uint8_t levels = 1;
+    th.restart(start_SOD);
+    cs.reset(start_SOD);
+    for (size_t i = 0; i < crp.size(); ++i) th.append_signal(starts[i], pids[i]);
+    th.set_shed_levels(levels);
+    g_parsed.clear();
+    g_cs = nullptr;
+    const int ret = th.flush();
+
+    bool ok = true;
+    std::vector<crp_status> kept;
+    uint32_t want_mask = 0;
+    for (const auto &e : crp) {
+      if (e.r > 0 && e.r + levels > cocs[e.c].NL) {
+        want_mask |= 1u << e.r;
+      } else {
+        kept.push_back(e);
+      }
+    }
+    if (ret != EXIT_SUCCESS) {
+      std::fprintf(stderr, "[FAIL] shed flush() returned %d\n", ret);
+      ok = false;
+    }
+    if (g_parsed.size() != kept.size()) {
+      std::fprintf(stderr, "[FAIL] shed: %zu precincts fired, expected the %zu kept\n", g_parsed.size(),
+                   kept.size());
+      ok = false;
+    }
+    for (size_t i = 0; ok && i < kept.size(); ++i) {
+      if (g_parsed[i].c != kept[i].c || g_parsed[i].r != kept[i].r || g_parsed[i].p != kept[i].p) {
+        std::fprintf(stderr, "[FAIL] shed: precinct %zu fired as (c=%u r=%u p=%u), expected (c=%u r=%u p=%u)\n",
+                     i, g_parsed[i].c, g_parsed[i].r, g_parsed[i].p, kept[i].c, kept[i].r, kept[i].p);
+        ok = false;
+      }
+    }
+    if (th.incomplete_levels() != want_mask) {
+      std::fprintf(stderr, "[FAIL] shed: incomplete_levels 0x%x, expected 0x%x\n", th.incomplete_levels(),
+                   want_mask);
+      ok = false;
+    }
+    if (ok) {
+      std::fprintf(stderr, "[PASS] %zu of %zu precincts parsed with the top level shed, mask 0x%x\n",
+                   kept.size(), crp.size(), want_mask);
+      return 0;
+    }
+    return 1;
+  }
+
+  std::fprintf(stderr, "error: unknown mode '%s' (want dump|parse|shed)\n", mode.c_str());
   return 2;
 }
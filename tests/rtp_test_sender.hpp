@@ -0,0 +1,118 @@
+// The stand-in RTP sender the loopback tests share: the packets it sends, the check a
+// test's hook runs on what arrives, and the socket it sends from.
+//
+// Packet `i` of a Stream carries sequence number first_seq + i (so a stream starting near
+// 65535 wraps early in the run), timestamp i / packets_per_ts with the marker on the last
+// packet of each timestamp, and payload byte k (counted from the start of the packet)
+// i * fill + k. Each test picks the payload lengths and the losses.
+#ifndef RTP_TEST_SENDER_HPP
+#define RTP_TEST_SENDER_HPP
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "rtp_receiver.hpp"
+
+namespace rtp_test {
+
+// Final packets of a run sent without loss: enough for the ring to give up on (or recover)
+// the last hole before the run ends, whatever is holding it — jitter depth, FEC matrix or
+// retransmission deadline.
+constexpr size_t kCleanTail = 2000;
+
+inline bool clean_tail(size_t i, size_t packets) { return i + kCleanTail >= packets; }
+
+struct Stream {
+  uint16_t first_seq;
+  uint32_t ssrc;
+  size_t packets_per_ts;
+  uint8_t fill;
+  uint8_t pt = 96;
+
+  uint16_t seq(size_t i) const { return static_cast<uint16_t>(first_seq + i); }
+  uint32_t timestamp(size_t i) const { return static_cast<uint32_t>(i / packets_per_ts); }
+  bool marker(size_t i) const { return i % packets_per_ts == packets_per_ts - 1; }
+
+  // Packet `i`: RTP header and `payload_len` bytes of payload.
+  std::vector<uint8_t> packet(size_t i, size_t payload_len) const {
+    std::vector<uint8_t> p(12 + payload_len);
+    const uint16_t s     = seq(i);
+    const uint32_t ts_be = htonl(timestamp(i));
+    const uint32_t ss_be = htonl(ssrc);
+    p[0]                 = 0x80;
+    p[1]                 = static_cast<uint8_t>(pt | (marker(i) ? 0x80 : 0));
+    p[2]                 = static_cast<uint8_t>(s >> 8);
+    p[3]                 = static_cast<uint8_t>(s);
+    std::memcpy(&p[4], &ts_be, 4);
+    std::memcpy(&p[8], &ss_be, 4);
+    for (size_t k = 12; k < p.size(); ++k) p[k] = static_cast<uint8_t>(i * fill + k);
+    return p;
+  }
+
+  // Whether the hook got packet `i`, sent as `sent`, intact.
+  bool intact(const rtp::Frame &f, size_t i, const std::vector<uint8_t> &sent) const {
+    return f.seq == seq(i) && f.payload_len == sent.size() - 12
+           && std::memcmp(f.payload, &sent[12], f.payload_len) == 0 && f.marker == marker(i)
+           && f.timestamp == timestamp(i) && f.ssrc == ssrc;
+  }
+};
+
+inline sockaddr_in loopback(uint16_t port) {
+  sockaddr_in a{};
+  a.sin_family = AF_INET;
+  a.sin_port   = htons(port);
+  ::inet_pton(AF_INET, "127.0.0.1", &a.sin_addr);
+  return a;
+}
+
+// One UDP socket sending to 127.0.0.1:port (or any other loopback port).
+struct Sender {
+  int fd;
+  sockaddr_in dst;
+
+  explicit Sender(uint16_t port) : fd(::socket(AF_INET, SOCK_DGRAM, 0)), dst(loopback(port)) {}
+  ~Sender() { ::close(fd); }
+  Sender(const Sender &)            = delete;
+  Sender &operator=(const Sender &) = delete;
+
+  void send(const std::vector<uint8_t> &p) const { send(p, dst); }
+  void send(const std::vector<uint8_t> &p, const sockaddr_in &to) const {
+    ::sendto(fd, p.data(), p.size(), 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+  }
+  // Call after sending packet `i`: bursts of 32, ~100k packets/s overall.
+  static void pace(size_t i) {
+    if (i % 32 == 31) std::this_thread::sleep_for(std::chrono::microseconds(300));
+  }
+};
+
+// Whether this process may open the AF_PACKET socket Ingest::kPacketRing needs
+// (CAP_NET_RAW); a test skips that backend, with a message, when it may not.
+inline bool can_packet_ring() {
+  const int fd = ::socket(AF_PACKET, SOCK_RAW, 0);
+  if (fd < 0) return false;
+  ::close(fd);
+  return true;
+}
+
+// Whether the running kernel is at least major.minor: Ingest::kIoUring needs 6.0 for
+// multishot recv (the provided-buffer ring alone is 5.19).
+inline bool kernel_at_least(int major, int minor) {
+  utsname u{};
+  int ma = 0, mi = 0;
+  if (::uname(&u) != 0 || std::sscanf(u.release, "%d.%d", &ma, &mi) != 2) return false;
+  return ma > major || (ma == major && mi >= minor);
+}
+
+}  // namespace rtp_test
+
+#endif  // RTP_TEST_SENDER_HPP
@@ -0,0 +1,224 @@
+// slab_bench — startup and dTLB cost of rtp::Receiver's slab pool backings.
+//
+// A paced sender streams RTP-shaped datagrams at 127.0.0.1 (one UDP GSO burst of 42 ×
+// 1400 B per millisecond, ~470 Mbps) from before the receiver starts. Per backing it
+// prints:
+//   start     — time spent in Receiver::start()
+//   first     — start() call to the first packet reaching the hook
+//   prefault  — start() call until the background prefault has populated the pool
+//   dTLB      — user-space dTLB load misses per 1000 packets on the worker thread,
+//               counted over the measurement window once the pool is populated
+// The hook reads one byte per cache line of each payload and keeps the last 1024 slabs
+// held (roughly one frame, as frame_handler does), so the worker walks the whole pool.
+// The first line is the old constructor's cost for comparison: zero-filling a
+// std::vector of the pool's size.
+//
+// usage: slab_bench [seconds_per_scenario=2]
+// dTLB counts need perf_event_open (kernel.perf_event_paranoid <= 2 and a PMU, which
+// many VMs do not expose); without it the column reads n/a. hugetlb needs
+// vm.nr_hugepages >= 13 for the default pool, else it falls back to thp.
+#include <arpa/inet.h>
+#include <linux/perf_event.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "rtp_receiver.hpp"
+
+namespace {
+
+constexpr uint16_t kPort    = 47110;
+constexpr size_t kPktBytes  = 1400;
+constexpr size_t kPerSend   = 42;  // one GSO burst, under the 64 KB limit
+constexpr size_t kHeldSlabs = 1024;
+using Clock                 = std::chrono::steady_clock;
+
+struct Ctx {
+  rtp::Receiver *rx = nullptr;
+  std::atomic<bool> first_seen{false};
+  Clock::time_point first;
+  std::atomic<size_t> packets{0};
+  uint32_t sink = 0;
+  // Worker-thread only: held slabs, and the dTLB counter over the measurement window.
+  std::vector<size_t> held;
+  size_t held_next = 0;
+  std::atomic<int> measure{0};  // main: 1 = open the counter, 2 = read and close it
+  std::atomic<bool> measured{false};
+  int perf_fd        = -1;
+  int perf_errno     = 0;
+  size_t perf_pkt0   = 0;
+  uint64_t misses    = 0;
+  size_t window_pkts = 0;
+};
+
+int open_dtlb_counter() {
+  perf_event_attr attr{};
+  attr.size           = sizeof(attr);
+  attr.type           = PERF_TYPE_HW_CACHE;
+  attr.config         = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  attr.exclude_kernel = 1;
+  attr.exclude_hv     = 1;
+  return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+void hook(void *arg, const rtp::Frame &f) {
+  auto *c = static_cast<Ctx *>(arg);
+  if (!c->first_seen.load(std::memory_order_relaxed)) {
+    c->first = Clock::now();
+    c->first_seen.store(true, std::memory_order_release);
+  }
+  for (size_t i = 0; i < f.payload_len; i += 64) c->sink += f.payload[i];
+  if (c->held[c->held_next] != SIZE_MAX) c->rx->release_slab(c->held[c->held_next]);
+  c->held[c->held_next] = f.slab_idx;
+  c->held_next          = (c->held_next + 1) % kHeldSlabs;
+  const size_t pkts     = c->packets.fetch_add(1, std::memory_order_relaxed) + 1;
+
+  const int m = c->measure.load(std::memory_order_acquire);
+  if (m == 1 && c->perf_fd < 0 && c->perf_errno == 0) {
+    c->perf_fd = open_dtlb_counter();
+    if (c->perf_fd < 0) {
+      c->perf_errno = errno;
+      c->measured.store(true, std::memory_order_release);
+    }
+    c->perf_pkt0 = pkts;
+  } else if (m == 2 && c->perf_fd >= 0) {
+    uint64_t v = 0;
+    if (::read(c->perf_fd, &v, sizeof(v)) == sizeof(v)) c->misses = v;
+    ::close(c->perf_fd);
+    c->perf_fd     = -1;
+    c->window_pkts = pkts - c->perf_pkt0;
+    c->measured.store(true, std::memory_order_release);
+  }
+}
+
+// Paced GSO bursts of kPktBytes datagrams until `stop` is set.
+void sender(std::atomic<bool> *stop) {
+  int fd  = ::socket(AF_INET, SOCK_DGRAM, 0);
+  int seg = static_cast<int>(kPktBytes);
+  if (::setsockopt(fd, IPPROTO_UDP, UDP_SEGMENT, &seg, sizeof(seg)) < 0) {
+    std::perror("setsockopt(UDP_SEGMENT)");
+    ::close(fd);
+    return;
+  }
+  sockaddr_in dst{};
+  dst.sin_family = AF_INET;
+  dst.sin_port   = htons(kPort);
+  ::inet_pton(AF_INET, "127.0.0.1", &dst.sin_addr);
+
+  std::vector<uint8_t> buf(kPerSend * kPktBytes, 0);
+  uint16_t seq = 0;
+  auto next    = Clock::now();
+  while (!stop->load(std::memory_order_relaxed)) {
+    for (size_t k = 0; k < kPerSend; ++k) {
+      uint8_t *p = buf.data() + k * kPktBytes;
+      p[0]       = 0x80;
+      p[1]       = 96;
+      p[2]       = static_cast<uint8_t>(seq >> 8);
+      p[3]       = static_cast<uint8_t>(seq);
+      ++seq;
+    }
+    ::sendto(fd, buf.data(), buf.size(), 0, reinterpret_cast<sockaddr *>(&dst), sizeof(dst));
+    next += std::chrono::milliseconds(1);
+    std::this_thread::sleep_until(next);
+  }
+  ::close(fd);
+}
+
+double ms_since(Clock::time_point t0, Clock::time_point t1) {
+  return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+void run(const char *name, double seconds, rtp::Receiver::SlabPages pages, bool prefault) {
+  rtp::Receiver rx;
+  rx.set_recv_buf_size(32 * 1024 * 1024);
+  rx.set_slab_memory(pages, false, prefault);
+  Ctx c;
+  c.rx = &rx;
+  c.held.assign(kHeldSlabs, SIZE_MAX);
+
+  std::atomic<bool> stop{false};
+  std::thread tx(sender, &stop);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));  // sender in steady state
+
+  const auto t0 = Clock::now();
+  if (!rx.start("127.0.0.1", kPort, &c, hook)) {
+    std::fprintf(stderr, "%s: receiver start failed\n", name);
+    stop.store(true);
+    tx.join();
+    return;
+  }
+  const auto t_started = Clock::now();
+
+  // Prefault completion (up to 5 s). Without prefault, receives fault pages in lazily.
+  double prefault_ms = -1;
+  while (prefault && ms_since(t0, Clock::now()) < 5000) {
+    if (rx.slab_prefaulted_bytes() >= rx.pool_bytes()) {
+      prefault_ms = ms_since(t0, Clock::now());
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  while (!c.first_seen.load(std::memory_order_acquire) && ms_since(t0, Clock::now()) < 5000)
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  const double first_ms = c.first_seen.load(std::memory_order_acquire) ? ms_since(t0, c.first) : -1;
+
+  c.measure.store(1, std::memory_order_release);
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  c.measure.store(2, std::memory_order_release);
+  for (int i = 0; i < 1000 && !c.measured.load(std::memory_order_acquire); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  stop.store(true);
+  tx.join();
+  rx.stop();
+
+  static const char *kPages[] = {"small", "thp", "hugetlb"};
+  char dtlb[64];
+  if (c.perf_errno != 0) {
+    std::snprintf(dtlb, sizeof(dtlb), "n/a (%s)", std::strerror(c.perf_errno));
+  } else if (c.window_pkts == 0) {
+    std::snprintf(dtlb, sizeof(dtlb), "n/a (no packets)");
+  } else {
+    std::snprintf(dtlb, sizeof(dtlb), "%.1f",
+                  static_cast<double>(c.misses) * 1000.0 / static_cast<double>(c.window_pkts));
+  }
+  char pf[32];
+  if (prefault) {
+    std::snprintf(pf, sizeof(pf), "%8.3f ms", prefault_ms);
+  } else {
+    std::snprintf(pf, sizeof(pf), "%11s", "off");
+  }
+  std::printf("%-12s %-8s start %7.3f ms  first %7.3f ms  prefault %s  dTLB/1k pkt %s\n", name,
+              kPages[static_cast<int>(rx.slab_pages())], ms_since(t0, t_started), first_ms, pf, dtlb);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const double seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+  {
+    rtp::Receiver probe;
+    const size_t bytes = probe.pool_bytes();
+    const auto t0      = Clock::now();
+    std::vector<uint8_t> pool(bytes, 0);
+    const auto t1 = Clock::now();
+    std::printf("slab pool %zu MB; zero-filled std::vector (old constructor) %.3f ms [%u]\n",
+                bytes / (1024 * 1024), ms_since(t0, t1), pool[bytes / 2]);
+  }
+  run("small", seconds, rtp::Receiver::SlabPages::kSmall, false);
+  run("small+pf", seconds, rtp::Receiver::SlabPages::kSmall, true);
+  run("thp+pf", seconds, rtp::Receiver::SlabPages::kThp, true);
+  run("hugetlb+pf", seconds, rtp::Receiver::SlabPages::kHugeTlb, true);
+  return 0;
+}